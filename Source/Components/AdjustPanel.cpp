@@ -111,6 +111,11 @@ AdjustPanel::~AdjustPanel() {
 
 void AdjustPanel::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void AdjustPanel::paramsRestored() {
+  mParamHasChanged.store(true);
+  repaint();
+}
+
 void AdjustPanel::timerCallback() {
   if (mParamHasChanged.load()) {
     mParamHasChanged.store(false);
@@ -49,6 +49,13 @@ ArcSpectrogram::ArcSpectrogram(Parameters& parameters) : juce::Thread("spectrogr
   };
   addAndMakeVisible(mSpecType);
 
+  initDetectionSlider(mDetectionSliders[0], mParameters.ui.noteSensitivity, "notes",
+                      "more or less notes detected, from the same transcription", {0.05, 0.95}, 0.01);
+  initDetectionSlider(mDetectionSliders[1], mParameters.ui.splitSensitivity, "splits",
+                      "split notes with the same pitch more, or merge them", {0.05, 0.95}, 0.01);
+  initDetectionSlider(mDetectionSliders[2], mParameters.ui.minNoteLengthMs, "min length", "shortest note kept",
+                      {10.0, 500.0}, 1.0, " ms");
+
   mActivePitchClass.reset(false);
 
   /*mParameters.note.onGrainCreated = [this](Utils::PitchClass pitchClass, int genIdx, float durationSec, float envGain) {
@@ -62,6 +69,30 @@ ArcSpectrogram::ArcSpectrogram(Parameters& parameters) : juce::Thread("spectrogr
   }; */
 }
 
+void ArcSpectrogram::initDetectionSlider(DetectionSlider& detection, std::atomic<float>& value, juce::String name,
+                                         juce::String tooltip, juce::Range<double> range, double interval,
+                                         juce::String suffix) {
+  detection.value = &value;
+  detection.slider.setRange(range, interval);
+  detection.slider.setValue(value.load(), juce::dontSendNotification);
+  detection.slider.setTextValueSuffix(suffix);
+  detection.slider.setTooltip(tooltip);
+  detection.slider.setPopupDisplayEnabled(true, true, this);
+  // Making the notes again takes a moment, only do it once the value is picked
+  detection.slider.setChangeNotificationOnlyOnRelease(true);
+  detection.slider.onValueChange = [this, &detection]() {
+    detection.value->store((float)detection.slider.getValue());
+    if (onNoteDetectionChanged != nullptr) onNoteDetectionChanged();
+  };
+  addChildComponent(detection.slider);
+
+  detection.label.setText(name, juce::dontSendNotification);
+  detection.label.setColour(juce::Label::ColourIds::textColourId, Utils::Colour::GLOBAL);
+  detection.label.setJustificationType(juce::Justification::centredRight);
+  detection.label.setFont(Utils::getFont());
+  addChildComponent(detection.label);
+}
+
 ArcSpectrogram::~ArcSpectrogram() {
   mParameters.note.onGrainCreated = nullptr;
   stopThread(BUFFER_PROCESS_TIMEOUT);
@@ -91,6 +122,13 @@ void ArcSpectrogram::paint(juce::Graphics& g) {
   }
 
   mSpecType.setVisible(mParameters.ui.specComplete);
+  const bool showDetection = mParameters.ui.specComplete && mSpecType.getSelectedId() == ParamUI::SpecType::DETECTED + 1;
+  for (DetectionSlider& detection : mDetectionSliders) {
+    detection.slider.setVisible(showDetection);
+    detection.label.setVisible(showDetection);
+    // Presets change the values as well
+    if (!detection.slider.isMouseButtonDown()) detection.slider.setValue(detection.value->load(), juce::dontSendNotification);
+  }
 
   // Note and Candidate can be null while loading new values
   if (!mParameters.ui.specComplete) return;
@@ -209,6 +247,14 @@ void ArcSpectrogram::resized() {
   // Spec type combobox
   mSpecType.setBounds(r.removeFromRight(SPEC_TYPE_WIDTH).removeFromTop(SPEC_TYPE_HEIGHT));
 
+  // Note detection sliders in the opposite corner
+  auto detectionRect = r.removeFromLeft(DETECTION_LABEL_WIDTH + DETECTION_SLIDER_WIDTH).reduced(5);
+  for (DetectionSlider& detection : mDetectionSliders) {
+    auto row = detectionRect.removeFromTop(DETECTION_SLIDER_HEIGHT);
+    detection.label.setBounds(row.removeFromLeft(DETECTION_LABEL_WIDTH));
+    detection.slider.setBounds(row);
+  }
+
   mStartPoint = juce::Point<int>(mRainbowRect.getWidth() / 2, mRainbowRect.getHeight());
   mCenterPoint = juce::Point<float>(getWidth() / 2.0f, mRainbowRect.getBottom());
   mStartRadius = (mRainbowRect.getWidth() / 2.0f) / 2.6f;
@@ -238,9 +284,7 @@ void ArcSpectrogram::run() {
 
   // Audio waveform (1D) is handled a bit differently than its 2D spectrograms
   if (mParameters.ui.specType == ParamUI::SpecType::WAVEFORM) {
-    juce::AudioBuffer<float>* audioBuffer = (juce::AudioBuffer<float>*)mBuffers[mParameters.ui.specType];
-    const float* bufferSamples = audioBuffer->getReadPointer(0);
-    float maxMagnitude = audioBuffer->getMagnitude(0, audioBuffer->getNumSamples());
+    const float* bufferSamples = (const float*)mBuffers[mParameters.ui.specType];
 
     // Draw NUM_COLS worth of audio samples
     juce::Point<float> prevPoint = mStartPoint.getPointOnCircumference(mStartRadius + mBowWidth / 2, mStartRadius + mBowWidth / 2,
@@ -248,13 +292,11 @@ void ArcSpectrogram::run() {
     juce::Colour prevColour = juce::Colours::black;
     for (auto i = 0; i < NUM_COLS; ++i) {
       if (threadShouldExit()) { mIsProcessing = false; return; }
-      int sampleIdx = ((float)i / NUM_COLS) * audioBuffer->getNumSamples();
-      float sampleRadius =
-          juce::jmap(bufferSamples[sampleIdx], -maxMagnitude, maxMagnitude, (float)mStartRadius, (float)mEndRadius);
+      float sampleRadius = juce::jmap(bufferSamples[i], -1.0f, 1.0f, (float)mStartRadius, (float)mEndRadius);
 
       // Choose rainbow color depending on radius
       auto rainbowColour =
-          juce::Colour::fromHSV(juce::jmap(bufferSamples[sampleIdx], -maxMagnitude, maxMagnitude, 0.0f, 1.0f), 1.0, 1.0f, 1.0f);
+          juce::Colour::fromHSV(juce::jmap(bufferSamples[i], -1.0f, 1.0f, 0.0f, 1.0f), 1.0, 1.0f, 1.0f);
 
       // Draw a line connecting to the previous point, blending colours between them
       float xPerc = ((float)i / NUM_COLS);
@@ -269,15 +311,17 @@ void ArcSpectrogram::run() {
   } else {
     // All other types of spectrograms
     Utils::SpecBuffer& spec = *(Utils::SpecBuffer*)mBuffers[mParameters.ui.specType];  // cast to SpecBuffer
-    if (spec.empty() || threadShouldExit()) { mIsProcessing = false; return; }
+    if (spec.isEmpty() || threadShouldExit()) { mIsProcessing = false; return; }
 
-    const float maxRow =
-        static_cast<float>((mParameters.ui.specType == ParamUI::SpecType::SPECTROGRAM) ? spec[0].size() / 8 : spec[0].size());
+    // Only the low end of the linear FFT bins is worth showing
+    const bool isLinearSpectrogram =
+        mParameters.ui.specType == ParamUI::SpecType::SPECTROGRAM && !mParameters.ui.isSpecLogFrequency;
+    const float maxRow = static_cast<float>(isLinearSpectrogram ? spec.getNumCols() / 8 : spec.getNumCols());
 
     // Draw each column of frequencies
     for (size_t i = 0; i < NUM_COLS; ++i) {
       if (threadShouldExit()) return;
-      const float specCol = ((float)i / NUM_COLS) * spec.size();
+      const float specCol = ((float)i / NUM_COLS) * spec.getNumRows();
       // Draw each row of frequencies
       for (auto curRadius = mStartRadius; curRadius < mEndRadius; curRadius += 1) {
         const float radPerc = (curRadius - mStartRadius) / (float)mBowWidth;
@@ -290,7 +334,7 @@ void ArcSpectrogram::run() {
         auto rainbowColour = juce::Colour::fromHSV(radPerc, 1.0, 1.0f, level);
         g.setColour(rainbowColour);
 
-        float xPerc = specCol / static_cast<float>(spec.size());
+        float xPerc = specCol / static_cast<float>(spec.getNumRows());
         float angleRad = (juce::MathConstants<float>::pi * xPerc) - (juce::MathConstants<float>::pi / 2.0f);
 
         // Create and rotate a rectangle to represent the "pixel"
@@ -309,6 +353,7 @@ void ArcSpectrogram::run() {
     }
   }
 
+  mParameters.ui.specImagesChanged();
   // pass type as another thread can change member variable right after run() is
   // done
   onImageComplete(mParameters.ui.specType);
@@ -330,6 +375,7 @@ void ArcSpectrogram::reset() {
   for (size_t i = 0; i < mParameters.ui.specImages.size(); i++) {
     mParameters.ui.specImages[i].clear(mParameters.ui.specImages[i].getBounds());
   }
+  mParameters.ui.specImagesChanged();
   for (int i = 0; i < (int)ParamUI::SpecType::COUNT; i++) {
     mImagesComplete[i] = false;
   }
@@ -350,13 +396,25 @@ void ArcSpectrogram::loadSpecBuffer(Utils::SpecBuffer* buffer, ParamUI::SpecType
   startThread();
 }
 
-void ArcSpectrogram::loadWaveformBuffer(juce::AudioBuffer<float>* audioBuffer) {
-  if (audioBuffer == nullptr) return;
+void ArcSpectrogram::reloadSpecBuffer(Utils::SpecBuffer* buffer, ParamUI::SpecType type,
+                                      const std::function<void()>& changeBuffer) {
+  // The old image is thrown away, no need to wait for it to finish drawing
+  stopThread(BUFFER_PROCESS_TIMEOUT);
+  if (changeBuffer != nullptr) changeBuffer();
+  mImagesComplete[type] = false;
+  loadSpecBuffer(buffer, type);
+}
+
+void ArcSpectrogram::loadWaveformBuffer(const Utils::SampleBuffer::View& samples) {
+  if (samples.numSamples == 0) return;
   waitForThreadToExit(BUFFER_PROCESS_TIMEOUT);
   if (mImagesComplete[ParamUI::SpecType::WAVEFORM]) return;
 
+  const float maxMagnitude = samples.getMagnitude(0, samples.numSamples);
+  const float gain = maxMagnitude > 0.0f ? 1.0f / maxMagnitude : 0.0f;
+  for (int i = 0; i < NUM_COLS; ++i) mWaveformCols[(size_t)i] = samples[(int)((float)i / NUM_COLS * samples.numSamples)] * gain;
   mParameters.ui.specType = ParamUI::SpecType::WAVEFORM;
-  mBuffers[mParameters.ui.specType] = audioBuffer;
+  mBuffers[mParameters.ui.specType] = mWaveformCols.data();
 
   // Only make image if component size has been set
   if (getWidth() > 0 && getHeight() > 0) {
@@ -24,6 +24,7 @@
 #include "Utils/Utils.h"
 #include "Utils/DSP.h"
 #include "Utils/MidiNote.h"
+#include "Utils/SampleBuffer.h"
 
 //==============================================================================
 /*
@@ -43,11 +44,16 @@ class ArcSpectrogram : public juce::AnimatedAppComponent, juce::Thread {
   void reset();
   bool shouldLoadImage(ParamUI::SpecType type) { return !mIsProcessing && !mImagesComplete[type]; }
   void loadSpecBuffer(Utils::SpecBuffer *buffer, ParamUI::SpecType type);
-  void loadWaveformBuffer(juce::AudioBuffer<float> *audioBuffer);  // Raw audio samples from file
+  // Draws the image of a spec that changed again, changeBuffer is called once nothing is drawing from the buffer anymore
+  void reloadSpecBuffer(Utils::SpecBuffer *buffer, ParamUI::SpecType type, const std::function<void()> &changeBuffer);
+  void loadWaveformBuffer(const Utils::SampleBuffer::View &samples);  // Raw audio samples from file
   void loadPreset();
   void setMidiNotes(const juce::Array<Utils::MidiNote> &midiNotes);
   void setSpecType(ParamUI::SpecType type) { mSpecType.setSelectedId(type + 1, juce::sendNotificationSync); }
 
+  // Called when a note detection slider is let go, after the new value is in ParamUI
+  std::function<void()> onNoteDetectionChanged = nullptr;
+
   //============================================================================
   void run() override;
 
@@ -58,6 +64,9 @@ class ArcSpectrogram : public juce::AnimatedAppComponent, juce::Thread {
   // UI variables
   static constexpr auto SPEC_TYPE_HEIGHT = 30;
   static constexpr auto SPEC_TYPE_WIDTH = 100;
+  static constexpr auto DETECTION_LABEL_WIDTH = 60;
+  static constexpr auto DETECTION_SLIDER_WIDTH = 100;
+  static constexpr auto DETECTION_SLIDER_HEIGHT = 20;
   static constexpr auto CANDIDATE_BUBBLE_SIZE = 14;
   static constexpr auto NUM_COLS = 600;
   // Colours
@@ -88,6 +97,8 @@ class ArcSpectrogram : public juce::AnimatedAppComponent, juce::Thread {
   // Bookkeeping
   // Buffers used to generate the images
   std::array<void *, ParamUI::SpecType::COUNT> mBuffers;
+  // The waveform is only drawn from NUM_COLS of its samples, normalized, which are kept instead of the audio
+  std::array<float, NUM_COLS> mWaveformCols;
   std::bitset<Utils::PitchClass::COUNT> mActivePitchClass;
   juce::Array<ArcGrain> mArcGrains;
   bool mIsProcessing = false;
@@ -107,6 +118,16 @@ class ArcSpectrogram : public juce::AnimatedAppComponent, juce::Thread {
 
   juce::ComboBox mSpecType;
 
+  // Note detection, only shown with the detected pitches
+  typedef struct DetectionSlider {
+    juce::Slider slider{juce::Slider::SliderStyle::LinearHorizontal, juce::Slider::TextEntryBoxPosition::NoTextBox};
+    juce::Label label;
+    std::atomic<float> *value = nullptr;
+  } DetectionSlider;
+  std::array<DetectionSlider, 3> mDetectionSliders;
+
+  void initDetectionSlider(DetectionSlider &detection, std::atomic<float> &value, juce::String name, juce::String tooltip,
+                           juce::Range<double> range, double interval, juce::String suffix = "");
   void onImageComplete(ParamUI::SpecType specType);
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ArcSpectrogram)
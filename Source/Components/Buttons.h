@@ -118,17 +118,17 @@ public:
           // Note is used, reset to global
           ParamHelper::setCommonParam(parameters.getSelectedParams(), mType, globalVal);
           ParamHelper::setCommonParam(note, mType, globalVal);
-          note->isUsed[mType] = false;
+          note->setUsed(mType, false);
         } else {
           // Nothing is used, reset to common default
           ParamHelper::setCommonParam(parameters.getSelectedParams(), mType, defaultVal);
           ParamHelper::setCommonParam(note, mType, defaultVal);
-          note->isUsed[mType] = false;
+          note->setUsed(mType, false);
           ParamHelper::setCommonParam(&parameters.global, mType, defaultVal);
         }
       }
     }
-    parameters.getSelectedParams()->isUsed[mType] = false;
+    parameters.getSelectedParams()->setUsed(mType, false);
     selectedCommonParamsChanged(parameters.getSelectedParams());
   }
 
@@ -140,6 +140,8 @@ public:
     setColour(juce::TextButton::buttonOnColourId, usedColour);    // Update active parameter pointer
     parameter = parameters.getUsedParam(newParams, mType);
   }
+  void paramsRestored() override { selectedCommonParamsChanged(parameters.getSelectedParams()); }
+  void usedParamsChanged() override { selectedCommonParamsChanged(parameters.getSelectedParams()); }
   juce::RangedAudioParameter* getParameter() { return parameter; }
 
 private:
@@ -59,6 +59,7 @@ EnvelopeADSR::EnvelopeADSR(Parameters& parameters)
   mParameters.global.ampEnvDecay->addListener(this);
   mParameters.global.ampEnvSustain->addListener(this);
   mParameters.global.ampEnvRelease->addListener(this);
+  mParameters.addListener(this);
   mParamHasChanged.store(true); // Init param values
 
   startTimer(Utils::UI_REFRESH_INTERVAL);
@@ -69,11 +70,14 @@ EnvelopeADSR::~EnvelopeADSR() {
   mParameters.global.ampEnvDecay->removeListener(this);
   mParameters.global.ampEnvSustain->removeListener(this);
   mParameters.global.ampEnvRelease->removeListener(this);
+  mParameters.removeListener(this);
   stopTimer();
 }
 
 void EnvelopeADSR::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void EnvelopeADSR::paramsRestored() { mParamHasChanged.store(true); }
+
 void EnvelopeADSR::timerCallback() {
   if (mParamHasChanged.load()) {
     mParamHasChanged.store(false);
@@ -89,6 +89,11 @@ EnvelopeGrain::~EnvelopeGrain() {
 
 void EnvelopeGrain::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void EnvelopeGrain::paramsRestored() {
+  mParamHasChanged.store(true);
+  repaint();
+}
+
 void EnvelopeGrain::timerCallback() {
   if (mParamHasChanged.load()) {
     mParamHasChanged.store(false);
@@ -33,6 +33,7 @@ public juce::Timer {
   void parameterGestureChanged(int, bool) override {}
   
   void selectedCommonParamsChanged(ParamCommon* newParams) override;
+  void paramsRestored() override;
 
   void timerCallback() override;
 
@@ -59,6 +59,7 @@ FilterControl::FilterControl(Parameters& parameters)
   mParameters.global.filterType->addListener(this);
   mParameters.global.filterCutoff->addListener(this);
   mParameters.global.filterRes->addListener(this);
+  mParameters.addListener(this);
 
   mParamHasChanged.store(true); // Init param values
 
@@ -69,6 +70,7 @@ FilterControl::~FilterControl() {
   mParameters.global.filterType->removeListener(this);
   mParameters.global.filterCutoff->removeListener(this);
   mParameters.global.filterRes->removeListener(this);
+  mParameters.removeListener(this);
   stopTimer();
 }
 
@@ -17,7 +17,7 @@
 //==============================================================================
 /*
  */
-class FilterControl : public juce::Component, juce::AudioProcessorParameter::Listener, juce::Timer {
+class FilterControl : public juce::Component, public Parameters::Listener, juce::AudioProcessorParameter::Listener, juce::Timer {
  public:
   FilterControl(Parameters& parameters);
   ~FilterControl() override;
@@ -27,6 +27,7 @@ class FilterControl : public juce::Component, juce::AudioProcessorParameter::Lis
 
   void parameterValueChanged(int idx, float value) override;
   void parameterGestureChanged(int, bool) override {}
+  void paramsRestored() override { mParamHasChanged.store(true); }
 
   void timerCallback() override;
 
@@ -130,6 +130,11 @@ MasterPanel::~MasterPanel() {
 
 void MasterPanel::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void MasterPanel::paramsRestored() {
+  mParamHasChanged.store(true);
+  repaint();
+}
+
 void MasterPanel::timerCallback() {
   if (mParamHasChanged.load()) {
     mParamHasChanged.store(false);
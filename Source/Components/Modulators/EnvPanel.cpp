@@ -69,6 +69,7 @@ EnvPanel::EnvPanel(int modIdx, Parameters& parameters)
   mModEnv.decay->addListener(this);
   mModEnv.sustain->addListener(this);
   mModEnv.release->addListener(this);
+  mParameters.addListener(this);
   mParamHasChanged.store(true); // Init param values
 
   startTimer(Utils::UI_REFRESH_INTERVAL);
@@ -79,6 +80,7 @@ EnvPanel::~EnvPanel() {
   mModEnv.decay->removeListener(this);
   mModEnv.sustain->removeListener(this);
   mModEnv.release->removeListener(this);
+  mParameters.removeListener(this);
   stopTimer();
 }
 
@@ -90,6 +92,8 @@ void EnvPanel::visibilityChanged() {
 
 void EnvPanel::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void EnvPanel::paramsRestored() { mParamHasChanged.store(true); }
+
 void EnvPanel::timerCallback() {
   if (mParamHasChanged.load()) {
     mParamHasChanged.store(false);
@@ -19,6 +19,7 @@
 /*
  */
 class EnvPanel : public juce::Component,
+public Parameters::Listener,
 public juce::AudioProcessorParameter::Listener,
 public juce::Timer {
  public:
@@ -30,6 +31,7 @@ public juce::Timer {
 
   void parameterValueChanged(int idx, float value) override;
   void parameterGestureChanged(int, bool) override {}
+  void paramsRestored() override;
   void visibilityChanged() override;
 
   void timerCallback() override;
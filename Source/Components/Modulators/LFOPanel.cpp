@@ -91,6 +91,7 @@ LFOPanel::LFOPanel(int modIdx, Parameters& parameters)
   mModLFO.sync->addListener(this);
   mModLFO.bipolar->addListener(this);
   mModLFO.retrigger->addListener(this);
+  mParameters.addListener(this);
 
   mParamHasChanged.store(true); // Init param values
 
@@ -105,6 +106,7 @@ LFOPanel::~LFOPanel() {
   mModLFO.sync->removeListener(this);
   mModLFO.bipolar->removeListener(this);
   mModLFO.retrigger->removeListener(this);
+  mParameters.removeListener(this);
   stopTimer();
 }
 
@@ -116,6 +118,8 @@ void LFOPanel::visibilityChanged() {
 
 void LFOPanel::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void LFOPanel::paramsRestored() { mParamHasChanged.store(true); }
+
 void LFOPanel::timerCallback() {
   bool updatePath = false;
   if (mParamHasChanged.load()) {
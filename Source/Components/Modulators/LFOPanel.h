@@ -18,7 +18,7 @@
 //==============================================================================
 /*
  */
-class LFOPanel : public juce::Component, juce::AudioProcessorParameter::Listener, juce::Timer {
+class LFOPanel : public juce::Component, public Parameters::Listener, juce::AudioProcessorParameter::Listener, juce::Timer {
  public:
   LFOPanel(int modIdx, Parameters& parameters);
   ~LFOPanel();
@@ -28,6 +28,7 @@ class LFOPanel : public juce::Component, juce::AudioProcessorParameter::Listener
 
   void parameterValueChanged(int idx, float value) override;
   void parameterGestureChanged(int, bool) override {}
+  void paramsRestored() override;
   void visibilityChanged() override;
 
   void timerCallback() override;
@@ -36,6 +36,11 @@ PianoPanel::~PianoPanel() {
 
 void PianoPanel::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void PianoPanel::paramsRestored() {
+  mParamHasChanged.store(true);
+  repaint();
+}
+
 void PianoPanel::timerCallback() {
   if (mParamHasChanged.load()) {
     mParamHasChanged.store(false);
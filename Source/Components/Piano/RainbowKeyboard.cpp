@@ -21,9 +21,11 @@ RainbowKeyboard::RainbowKeyboard(juce::MidiKeyboardState& state, Parameters& par
       gen->enable->addListener(this);
     }
   }
+  mParameters.addListener(this);
 }
 
 RainbowKeyboard::~RainbowKeyboard() {
+  mParameters.removeListener(this);
   for (auto& note : mParameters.note.notes) {
     for (auto& gen : note->generators) {
       gen->enable->removeListener(this);
@@ -24,6 +24,7 @@
   The RainbowKeyboard is able to detect mouse input and inject midi inputs
 */
 class RainbowKeyboard : public juce::Component,
+public Parameters::Listener,
 public juce::AudioProcessorParameter::Listener {
  public:
   RainbowKeyboard(juce::MidiKeyboardState& state, Parameters& parameters);
@@ -34,6 +35,7 @@ public juce::AudioProcessorParameter::Listener {
 
   void parameterValueChanged(int parameterIndex, float newValue) override;
   void parameterGestureChanged(int, bool) override {}
+  void paramsRestored() override { resized(); }
 
   void mouseMove(const juce::MouseEvent&) override;
   void mouseDrag(const juce::MouseEvent&) override;
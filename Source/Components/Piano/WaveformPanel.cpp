@@ -45,16 +45,20 @@ WaveformPanel::WaveformPanel(Parameters& parameters)
   mBtnLock.setClickingTogglesState(true);
   addChildComponent(mBtnLock);
 
+  mParameters.addListener(this);
   startTimer(100);
 }
 
 WaveformPanel::~WaveformPanel() {
+  mParameters.removeListener(this);
   mCurSelectedParams->removeListener(this);
   stopTimer();
 }
 
 void WaveformPanel::parameterValueChanged(int, float) { mParamHasChanged.store(true); }
 
+void WaveformPanel::paramsRestored() { mParamHasChanged.store(true); }
+
 void WaveformPanel::timerCallback() {
   if (mParamHasChanged.load()) {
     mParamHasChanged.store(false);
@@ -79,12 +83,12 @@ void WaveformPanel::updateSelectedParams() {
 
   bool isGeneratorMode = mCurSelectedParams->type == ParamType::GENERATOR;
   // Set zoom range
-  if (isGeneratorMode && mBuffer.getNumSamples() > 0) {
+  if (isGeneratorMode && mNumSamples > 0) {
     gen = dynamic_cast<ParamGenerator*>(mCurSelectedParams);
-    if (gen) {
-      ParamCandidate* candidate = mParameters.getGeneratorCandidate(gen);
-      int start = candidate->posRatio * mBuffer.getNumSamples();
-      int end = start + (candidate->duration * mBuffer.getNumSamples());
+    ParamCandidate* candidate = mParameters.getGeneratorCandidate(gen);
+    if (gen && candidate) {
+      int start = candidate->posRatio * mNumSamples;
+      int end = start + (candidate->duration * mNumSamples);
       int duration = end - start;
       mZoomRange = juce::Range<int>(start - duration / 2, end + duration / 2);
       mBtnGenEnable.setVisible(true);
@@ -93,7 +97,7 @@ void WaveformPanel::updateSelectedParams() {
       ParamHelper::setParam(mParameters.note.notes[gen->noteIdx]->soloIdx, gen->genIdx);
     }
   } else {
-    mZoomRange = juce::Range<int>(0, mBuffer.getNumSamples());
+    mZoomRange = juce::Range<int>(0, mNumSamples);
     mBtnGenEnable.setVisible(false);
     mBtnLock.setVisible(false);
   }
@@ -114,7 +118,7 @@ void WaveformPanel::paint(juce::Graphics& g) {
   g.fillRoundedRectangle(r.reduced(Utils::PADDING / 2.0), 10.0f);
 
   // Wave bars
-  if (mBuffer.getNumSamples() == 0) return; // Skip if we don't even have a buffer
+  if (mNumSamples == 0) return; // Skip if we don't even have a buffer
   g.setColour(Utils::Colour::GLOBAL);
   for (WaveBar& bar : mWaveBars) {
     auto barColour =
@@ -131,7 +135,7 @@ void WaveformPanel::paint(juce::Graphics& g) {
 }
 
 void WaveformPanel::resized() {
-  if (mBuffer.getNumSamples() == 0) return; // Skip if we don't even have a buffer
+  if (mNumSamples == 0) return; // Skip if we don't even have a buffer
   auto r = getLocalBounds().reduced(Utils::PADDING, Utils::PADDING);
 
   // Positioning lock and enable buttons
@@ -148,31 +152,37 @@ void WaveformPanel::resized() {
   }
 }
 
-void WaveformPanel::load(juce::AudioBuffer<float> &buffer) {
-  mBuffer.setSize(1, buffer.getNumSamples());
-  float gain = 1.0f / buffer.getMagnitude(0, 0, buffer.getNumSamples());
-  mBuffer.copyFrom(0, 0, buffer.getReadPointer(0), buffer.getNumSamples(), gain);
-  mZoomRange = juce::Range<int>(0, mBuffer.getNumSamples());
+void WaveformPanel::load(const Utils::SampleBuffer::View &samples) {
+  mNumSamples = samples.numSamples;
+  mPeaks.resize((size_t)((mNumSamples + PEAK_BLOCK_SAMPLES - 1) / PEAK_BLOCK_SAMPLES));
+  float peak = 0.0f;
+  for (size_t i = 0; i < mPeaks.size(); ++i) {
+    const int start = (int)i * PEAK_BLOCK_SAMPLES;
+    mPeaks[i] = samples.getMagnitude(start, juce::jmin(PEAK_BLOCK_SAMPLES, mNumSamples - start));
+    peak = juce::jmax(peak, mPeaks[i]);
+  }
+  if (peak > 0.0f) juce::FloatVectorOperations::multiply(mPeaks.data(), 1.0f / peak, (int)mPeaks.size());
+  mZoomRange = juce::Range<int>(0, mNumSamples);
   mSamplesPerBar = mZoomRange.getLength() / NUM_WAVE_BARS;
   updateWaveBars();
 }
 
 void WaveformPanel::updateWaveBars() {
-  if (mBuffer.getNumSamples() == 0) return;
+  if (mNumSamples == 0) return;
 
   auto* gen = dynamic_cast<ParamGenerator*>(mCurSelectedParams);
   ParamCandidate* candidate = nullptr;
   juce::Range<int> cRange; // Candidate sample range
-  if (gen) {
-    candidate = mParameters.getGeneratorCandidate(gen);
-    cRange.setStart(candidate->posRatio * mBuffer.getNumSamples());
-    cRange.setLength(candidate->duration * mBuffer.getNumSamples() + 1);
+  if (gen) candidate = mParameters.getGeneratorCandidate(gen);
+  if (candidate) {
+    cRange.setStart(candidate->posRatio * mNumSamples);
+    cRange.setLength(candidate->duration * mNumSamples + 1);
   }
 
   // Populate wave bar magnitudes
   int curSample = mZoomRange.getStart();
   for (auto& bar : mWaveBars) {
-    float magnitude = (curSample >= 0 && (curSample + mSamplesPerBar) < mBuffer.getNumSamples()) ? mBuffer.getMagnitude(0, curSample, mSamplesPerBar) : 0.0f;
+    float magnitude = (curSample >= 0 && (curSample + mSamplesPerBar) < mNumSamples) ? getMagnitude(curSample, mSamplesPerBar) : 0.0f;
     bar = WaveBar(magnitude);
     if (candidate) {
       // Color the bars within candidate area
@@ -198,12 +208,21 @@ void WaveformPanel::updateWaveBars() {
   repaint();
 }
 
+float WaveformPanel::getMagnitude(int start, int numSamples) const {
+  float magnitude = 0.0f;
+  if (numSamples <= 0) return magnitude;
+  for (int i = start / PEAK_BLOCK_SAMPLES; i <= (start + numSamples - 1) / PEAK_BLOCK_SAMPLES; ++i) {
+    magnitude = juce::jmax(magnitude, mPeaks[(size_t)i]);
+  }
+  return magnitude;
+}
+
 void WaveformPanel::addBarsForNote(ParamNote* note, bool showCandidates) {
   if (note->candidates.empty()) return;
   for (auto& gen : note->generators) {
     if (!gen->enable->get() && !showCandidates) continue; // Skip if generator is off (unless we want to show its candidate)
     auto& candidate = note->candidates[gen->candidate->get()];
-    int sample = candidate.posRatio * mBuffer.getNumSamples();
+    int sample = candidate.posRatio * mNumSamples;
     if (!mZoomRange.contains(sample)) continue; // Skip if we're outside of the visible range
     // Find the wave bar closest to this generator
     int closestBarIdx = juce::roundToInt((sample - mZoomRange.getStart()) / (float)mSamplesPerBar);
@@ -215,7 +234,7 @@ void WaveformPanel::addBarsForNote(ParamNote* note, bool showCandidates) {
 
 void WaveformPanel::mouseMove(const juce::MouseEvent& evt) {
   mHoverBar = nullptr;
-  if (mBuffer.getNumSamples() == 0 || mCurSelectedParams->type == ParamType::GENERATOR) { repaint(); return; }
+  if (mNumSamples == 0 || mCurSelectedParams->type == ParamType::GENERATOR) { repaint(); return; }
   auto pos = evt.getEventRelativeTo(this).getPosition();
   for (auto& bar : mWaveBars) {
     if (bar.rect.contains(pos.toFloat())) {
@@ -238,10 +257,10 @@ void WaveformPanel::mouseDrag(const juce::MouseEvent& evt) {
   ParamCandidate* candidate = mParameters.getGeneratorCandidate(gen);
   if (!candidate) return;
   const double diffProportion = (evt.getPosition().x - mLastDragX) / (double)getWidth();
-  const double zoomProportion = mZoomRange.getLength() / (double)mBuffer.getNumSamples();
+  const double zoomProportion = mZoomRange.getLength() / (double)mNumSamples;
   candidate->posRatio -= diffProportion * zoomProportion;
-  int start = candidate->posRatio * mBuffer.getNumSamples();
-  int end = start + (candidate->duration * mBuffer.getNumSamples());
+  int start = candidate->posRatio * mNumSamples;
+  int end = start + (candidate->duration * mNumSamples);
   int duration = end - start;
   mZoomRange = juce::Range<int>(start - duration / 2, end + duration / 2);
   mLastDragX = evt.getPosition().x;
@@ -13,11 +13,12 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "Parameters.h"
 #include "Components/Sliders.h"
+#include "Utils/SampleBuffer.h"
 
 //==============================================================================
 /*
  */
-class WaveformPanel : public juce::Component, juce::AudioProcessorParameter::Listener, juce::Timer {
+class WaveformPanel : public juce::Component, public Parameters::Listener, juce::AudioProcessorParameter::Listener, juce::Timer {
  public:
   WaveformPanel(Parameters& parameters);
   ~WaveformPanel();
@@ -27,6 +28,7 @@ class WaveformPanel : public juce::Component, juce::AudioProcessorParameter::Lis
 
   void parameterValueChanged(int idx, float value) override;
   void parameterGestureChanged(int, bool) override {}
+  void paramsRestored() override;
 
   void timerCallback() override;
 
@@ -38,11 +40,12 @@ class WaveformPanel : public juce::Component, juce::AudioProcessorParameter::Lis
 
   void updateSelectedParams();
 
-  bool isLoaded() { return mBuffer.getNumSamples() > 0; }
-  void load(juce::AudioBuffer<float> &buffer);
+  bool isLoaded() { return mNumSamples > 0; }
+  void load(const Utils::SampleBuffer::View &samples);
 
  private:
   static constexpr int NUM_WAVE_BARS = 40;
+  static constexpr int PEAK_BLOCK_SAMPLES = 64;
 
   typedef struct WaveBar {
     WaveBar() {}
@@ -57,6 +60,7 @@ class WaveformPanel : public juce::Component, juce::AudioProcessorParameter::Lis
   } WaveBar;
 
   void updateWaveBars();
+  float getMagnitude(int start, int numSamples) const;
   void addBarsForNote(ParamNote* note, bool showCandidates);
 
   // Components
@@ -69,7 +73,9 @@ class WaveformPanel : public juce::Component, juce::AudioProcessorParameter::Lis
   std::atomic<bool> mParamHasChanged;
   juce::Colour mParamColour;
 
-  juce::AudioBuffer<float> mBuffer;
+  // Normalized peak of each PEAK_BLOCK_SAMPLES of the audio, the bars only need that much of it
+  std::vector<float> mPeaks;
+  int mNumSamples = 0;
   std::array<WaveBar, NUM_WAVE_BARS> mWaveBars;
   juce::Range<int> mZoomRange; // Zoom range in samples
   int mSamplesPerBar;
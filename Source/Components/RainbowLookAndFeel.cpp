@@ -75,7 +75,7 @@ void RainbowLookAndFeel::drawRotarySlider(juce::Graphics& g, int, int, int, int,
   ParamSlider* paramSlider = dynamic_cast<ParamSlider*>(&slider);
   if (paramSlider && paramSlider->getParameter()) {
     // Check for modulations on this param and visualize them
-    const int idx = paramSlider->getParameter()->getParameterIndex();
+    const int idx = paramSlider->parameters.getParamIndex(paramSlider->getParameter());
     if (paramSlider->parameters.modulations.contains(idx)) {
       Modulation& mod = paramSlider->parameters.modulations.getReference(idx);
       // Draw inner arc representing modulation range
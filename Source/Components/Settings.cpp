@@ -9,6 +9,7 @@
 */
 
 #include "Settings.h"
+#include "Utils/Files.h"
 
 void PowerUserSettings::resetParameters() {
   if (mSynth != nullptr) {
@@ -39,6 +40,39 @@ SettingsComponent::SettingsComponent() {
   mBtnResourceUsage.setToggleState(false, juce::NotificationType::dontSendNotification);
   mBtnResourceUsage.onClick = [this] { PowerUserSettings::get().setResourceUsage(mBtnResourceUsage.getToggleState()); };
   addAndMakeVisible(mBtnResourceUsage);
+
+  // Hosts only read the parameter list when the plugin is created, so this applies the next time it is loaded
+  mBtnCompactParams.setButtonText("Compact host params");
+  mBtnCompactParams.setTooltip(
+      "Only give global parameters and the host slots to the host, takes effect on the next load. Sessions automating note "
+      "parameters directly need it off");
+  mBtnCompactParams.setColour(juce::TextButton::buttonColourId, juce::Colours::red);
+  mBtnCompactParams.setColour(juce::TextButton::buttonOnColourId, juce::Colours::green);
+  mBtnCompactParams.setToggleState(Utils::getHostParamsCompact(), juce::NotificationType::dontSendNotification);
+  mBtnCompactParams.setClickingTogglesState(true);
+  mBtnCompactParams.onClick = [this] { Utils::setHostParamsCompact(mBtnCompactParams.getToggleState()); };
+  addAndMakeVisible(mBtnCompactParams);
+
+  mBtnCompactAudio.setButtonText("16 bit samples");
+  mBtnCompactAudio.setTooltip(
+      "Keep loaded audio as 16 bit samples to use half the memory, applies to audio loaded after. Only the first channel "
+      "is kept and presets and sessions save it as 16 bit too");
+  mBtnCompactAudio.setColour(juce::TextButton::buttonColourId, juce::Colours::red);
+  mBtnCompactAudio.setColour(juce::TextButton::buttonOnColourId, juce::Colours::green);
+  mBtnCompactAudio.setToggleState(Utils::getCompactAudio(), juce::NotificationType::dontSendNotification);
+  mBtnCompactAudio.setClickingTogglesState(true);
+  mBtnCompactAudio.onClick = [this] { Utils::setCompactAudio(mBtnCompactAudio.getToggleState()); };
+  addAndMakeVisible(mBtnCompactAudio);
+
+  mBtnSpecsFromFeatures.setButtonText("Specs from CQT");
+  mBtnSpecsFromFeatures.setTooltip(
+      "Make the spectrogram and harmonic profile from the pitch detection, faster but coarser, applies to audio analyzed after");
+  mBtnSpecsFromFeatures.setColour(juce::TextButton::buttonColourId, juce::Colours::red);
+  mBtnSpecsFromFeatures.setColour(juce::TextButton::buttonOnColourId, juce::Colours::green);
+  mBtnSpecsFromFeatures.setToggleState(Utils::getSpecsFromFeatures(), juce::NotificationType::dontSendNotification);
+  mBtnSpecsFromFeatures.setClickingTogglesState(true);
+  mBtnSpecsFromFeatures.onClick = [this] { Utils::setSpecsFromFeatures(mBtnSpecsFromFeatures.getToggleState()); };
+  addAndMakeVisible(mBtnSpecsFromFeatures);
 }
 
 SettingsComponent::~SettingsComponent() {}
@@ -56,4 +90,7 @@ void SettingsComponent::resized() {
   mBtnAnimation.setBounds(r.removeFromTop(buttonHeight).withWidth(buttonWidth));
   mBtnResetParameters.setBounds(r.removeFromTop(buttonHeight).withWidth(buttonWidth));
   mBtnResourceUsage.setBounds(r.removeFromTop(buttonHeight).withWidth(buttonWidth));
+  mBtnCompactParams.setBounds(r.removeFromTop(buttonHeight).withWidth(buttonWidth));
+  mBtnCompactAudio.setBounds(r.removeFromTop(buttonHeight).withWidth(buttonWidth));
+  mBtnSpecsFromFeatures.setBounds(r.removeFromTop(buttonHeight).withWidth(buttonWidth));
 }
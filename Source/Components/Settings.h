@@ -59,11 +59,14 @@ class SettingsComponent : public juce::Component {
   void resized() override;
 
   // height of setting component
-  int getHeight() { return 100; }
+  int getHeight() { return 190; }
 
 private:
   const int mDivideLineSize = 5;
   juce::TextButton mBtnAnimation;
   juce::TextButton mBtnResetParameters;
   juce::TextButton mBtnResourceUsage;
+  juce::TextButton mBtnCompactParams;
+  juce::TextButton mBtnCompactAudio;
+  juce::TextButton mBtnSpecsFromFeatures;
 };
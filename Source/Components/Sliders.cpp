@@ -19,7 +19,7 @@ ParamSlider::ParamSlider(Parameters& _parameters, juce::RangedAudioParameter* _p
   setSkewFactor(parameter->getNormalisableRange().skew);
   onValueChange = [this] {
     if (parameters.getMappingModSource()) {
-      int idx = parameter->getParameterIndex();
+      int idx = parameters.getParamIndex(parameter);
       if (!parameters.modulations.contains(idx)) {
         // Add modulator if it doesn't exist
         parameters.modulations.set(idx, Modulation(parameters.getMappingModSource(), 0.0f));
@@ -40,6 +40,20 @@ ParamSlider::ParamSlider(Parameters& _parameters, juce::RangedAudioParameter* _p
   };
 }
 
+void ParamSlider::addHostSlotItem(juce::PopupMenu& menu) {
+  if (parameter == nullptr) return;
+  ParamRegistry& registry = parameters.getRegistry();
+  juce::RangedAudioParameter* param = parameter;
+  const int slot = registry.getHostSlot(param);
+  if (slot >= 0) {
+    menu.addItem("Remove from host slot " + juce::String(slot + 1), [&registry, slot]() { registry.setHostSlot(slot, nullptr); });
+  } else {
+    const int freeSlot = registry.getFreeHostSlot();
+    menu.addItem("Automate in host slot " + juce::String(freeSlot + 1), freeSlot >= 0, false,
+                 [&registry, freeSlot, param]() { registry.setHostSlot(freeSlot, param); });
+  }
+}
+
 CommonSlider::CommonSlider(Parameters& _parameters, ParamCommon::Type type)
 : ParamSlider(_parameters, _parameters.global.common[type]), mType(type) {
   parameters.addListener(this);
@@ -57,7 +71,7 @@ CommonSlider::CommonSlider(Parameters& _parameters, ParamCommon::Type type)
   setColour(juce::Slider::ColourIds::rotarySliderOutlineColourId, Utils::Colour::GLOBAL);
   onValueChange = [this] {
     if (parameters.getMappingModSource()) {
-      int idx = parameter->getParameterIndex();
+      int idx = parameters.getParamIndex(parameter);
       if (!parameters.modulations.contains(idx)) {
         // Add modulator if it doesn't exist
         parameters.modulations.set(idx, Modulation(parameters.getMappingModSource(), 0.0f));
@@ -122,17 +136,17 @@ void CommonSlider::mouseDoubleClick(const juce::MouseEvent&) {
         // Note is used, reset to global
         ParamHelper::setCommonParam(parameters.getSelectedParams(), mType, globalVal);
         ParamHelper::setCommonParam(note, mType, globalVal);
-        note->isUsed[mType] = false;
+        note->setUsed(mType, false);
       } else {
         // Nothing is used, reset to common default
         ParamHelper::setCommonParam(parameters.getSelectedParams(), mType, defaultVal);
         ParamHelper::setCommonParam(note, mType, defaultVal);
-        note->isUsed[mType] = false;
+        note->setUsed(mType, false);
         ParamHelper::setCommonParam(&parameters.global, mType, defaultVal);
       }
     }
   }
-  parameters.getSelectedParams()->isUsed[mType] = false;
+  parameters.getSelectedParams()->setUsed(mType, false);
   selectedCommonParamsChanged(parameters.getSelectedParams());
 }
 
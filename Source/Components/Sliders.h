@@ -20,15 +20,16 @@ public:
   
   void mouseDown(const juce::MouseEvent &evt) override {
     if (evt.mods.isPopupMenu()) {
+      juce::PopupMenu menu;
       // If modulations exist on this slider, let the user choose to remove them
-      int idx = parameter->getParameterIndex();
+      int idx = parameters.getParamIndex(parameter);
       if (parameters.modulations.contains(idx)) {
-        juce::PopupMenu menu;
         menu.addItem("Remove modulation", [this, idx]() {
           parameters.modulations.remove(idx);
         });
-        menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this));
       }
+      addHostSlotItem(menu);
+      if (menu.getNumItems() > 0) menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this));
     } else {
       juce::Slider::mouseDown(evt);
     }
@@ -46,6 +47,9 @@ protected:
   juce::RangedAudioParameter* parameter;
   float dragStartValue;
 private:
+  // Lets the user automate the parameter through a host slot, the way to reach internal parameters in compact mode
+  void addHostSlotItem(juce::PopupMenu& menu);
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParamSlider)
 };
 
@@ -60,6 +64,8 @@ class CommonSlider : public ParamSlider, public Parameters::Listener {
   void mouseDoubleClick(const juce::MouseEvent& evt) override;
   
   void selectedCommonParamsChanged(ParamCommon* newParams) override;
+  void paramsRestored() override { selectedCommonParamsChanged(parameters.getSelectedParams()); }
+  void usedParamsChanged() override { selectedCommonParamsChanged(parameters.getSelectedParams()); }
 
  private:
   // Get the colour of the parameter at the level that's used (global, note)
@@ -142,10 +142,9 @@ void TrimSelection::paint(juce::Graphics& g) {
   }
 }
 
-void TrimSelection::parse(const juce::AudioBuffer<float>& audioBuffer, double sampleRate, juce::String& error) {
+void TrimSelection::parse(juce::File file, double duration, double sampleRate, juce::String& error) {
   cleanup();  // in case while trim selecting, user selects a new file
   mSampleRate = sampleRate;
-  const double duration = static_cast<double>(audioBuffer.getNumSamples()) / mSampleRate;
   if (duration <= MIN_SELECTION_SEC) {
     error = juce::String("The audio file is  ") + juce::String(duration) + " seconds but must be greater than " +
             juce::String(MIN_SELECTION_SEC) + " seconds.";
@@ -154,14 +153,9 @@ void TrimSelection::parse(const juce::AudioBuffer<float>& audioBuffer, double sa
     return;
   }
 
-  // It is slightly faster to use the setReader() with the AudioFormatReader for the thumbnail and make use of
-  // juce::AudioThumbnailCache, but the main reasons to add the thumbnail block manually are
-  // 1. The file might be at a different sampleRate than the audio buffer which can seem like it doesn't match the playback
-  // 2. It is possible to update the thumbnail if the audio buffer is modified
-  // 3. It is not obvious that setReader() will delete the AudioFormatReader when called a second time
-  mThumbnail.clear();
-  mThumbnail.reset(audioBuffer.getNumChannels(), mSampleRate, audioBuffer.getNumSamples());
-  mThumbnail.addBlock(0, audioBuffer, 0, audioBuffer.getNumSamples());
+  // The file is never decoded as a whole up front, the thumbnail reads it in chunks on the cache's thread and fills in
+  // as the editor repaints. Everything is drawn in seconds so the file's own sample rate doesn't matter
+  mThumbnail.setSource(new juce::FileInputSource(file));
 
   audioSampleDuration = duration;
   // start with everything selected
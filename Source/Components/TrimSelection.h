@@ -71,7 +71,8 @@ class TrimSelection : public juce::Component {
   void paint(juce::Graphics& g) override;
   void resized() override;
 
-  void parse(const juce::AudioBuffer<float>& audioBuffer, double sampleRate, juce::String& error);
+  // The thumbnail is built from the file in the background, sampleRate is the one trimPlaybackSample counts in
+  void parse(juce::File file, double duration, double sampleRate, juce::String& error);
 
   std::function<void(void)> onCancel = nullptr;
   std::function<void(juce::Range<double>)> onProcessSelection = nullptr;
@@ -11,63 +11,65 @@
 #include "Fft.h"
 
 Fft::Fft(int windowSize, int hopSize)
-    : mWindowSize(windowSize),
-      mHopSize(hopSize),
-      mForwardFFT(std::log2(windowSize)),
-      mWindowEnvelope(windowSize, juce::dsp::WindowingFunction<float>::WindowingMethod::blackmanHarris) {}
+    : mWindowSize(windowSize), mHopSize(hopSize), mOrder((int)std::log2(windowSize)), mWindow((size_t)windowSize) {
+  juce::dsp::WindowingFunction<float>::fillWindowingTables(
+      mWindow.data(), (size_t)windowSize, juce::dsp::WindowingFunction<float>::WindowingMethod::blackmanHarris, false);
+}
 
 Fft::~Fft() {}
 
 void Fft::clear(bool clearData) {
-  mFftFrame.clear();
-  if (clearData) {
-    // The FFT can take up a lot of memory, need to not just clear, but have STD deallocate it
-    mFftData.clear();
-    mFftData.shrink_to_fit();
-  }
+  // The FFT can take up a lot of memory, need to not just clear, but deallocate it
+  if (clearData) mFftData.clear();
 }
 
 Utils::SpecBuffer* Fft::process(const juce::AudioBuffer<float>* audioBuffer) {
-  mInputBuffer = audioBuffer;
   clear(true);
   // Runs with first channel
-  const int numInputSamples = mInputBuffer->getNumSamples();
-  const float* pBuffer = mInputBuffer->getReadPointer(0);
-  mFftFrame.resize(mWindowSize * 2, 0.0f);
-  int curSample = 0;
-  bool hasData = numInputSamples > mFftFrame.size();
-  float curMax = std::numeric_limits<float>::min();
+  const int numInputSamples = audioBuffer->getNumSamples();
+  const float* input = audioBuffer->getReadPointer(0);
+  const int numFrames = (numInputSamples + mHopSize - 1) / mHopSize;
+  // Only the non-negative frequencies below Nyquist
+  mFftData.resize((size_t)numFrames, (size_t)mWindowSize / 2);
+
+  const int numTasks = (numFrames + FRAMES_PER_TASK - 1) / FRAMES_PER_TASK;
+  Utils::parallelFor(mPool->pool, numTasks, [&](int task) {
+    const int startFrame = task * FRAMES_PER_TASK;
+    processFrames(input, numInputSamples, startFrame, juce::jmin(FRAMES_PER_TASK, numFrames - startFrame));
+  });
 
-  while (hasData) {
-//    updateProgress(mStartProgress + (mDiffProgress * (static_cast<double>(curSample) / static_cast<double>(numInputSamples))));
-    const float* startSample = &pBuffer[curSample];
-    int numSamples = mFftFrame.size();
-    if (curSample + mFftFrame.size() > numInputSamples) {
-      numSamples = (numInputSamples - curSample);
+  // Normalize once everything is known, so every frame has the same scale
+  float maxValue = 0.0f;
+  for (size_t frame = 0; frame < mFftData.getNumRows(); ++frame) {
+    maxValue = juce::jmax(maxValue, juce::FloatVectorOperations::findMaximum(mFftData[frame], (int)mFftData.getNumCols()));
+  }
+  if (maxValue > 0.0f) {
+    for (size_t frame = 0; frame < mFftData.getNumRows(); ++frame) {
+      juce::FloatVectorOperations::multiply(mFftData[frame], 1.0f / maxValue, (int)mFftData.getNumCols());
     }
-    mFftFrame.clear();
-    mFftFrame.resize(mWindowSize * 2, 0.0f);
-    memcpy(mFftFrame.data(), startSample, numSamples);
-    mWindowEnvelope.multiplyWithWindowingTable(mFftFrame.data(), mFftFrame.size());
+  }
 
-    // then render our FFT data..
-    mForwardFFT.performFrequencyOnlyForwardTransform(mFftFrame.data());
+  return &mFftData;
+}
 
-    // Add fft data to our master array
-    std::vector<float> newFrame = std::vector<float>(mFftFrame.begin(), mFftFrame.begin() + (mWindowSize / 2));
-    float frameMax = juce::FloatVectorOperations::findMaximum(mFftFrame.data(), mFftFrame.size());
-    if (frameMax > curMax) curMax = frameMax;
-    mFftData.push_back(newFrame);
-    // Normalize fft values according to max frame value
-    for (size_t i = 0; i < mFftData.back().size(); ++i) {
-      mFftData.back()[i] /= curMax;
-    }
+void Fft::processFrames(const float* input, int numInputSamples, int startFrame, int numFrames) {
+  juce::dsp::FFT fft(mOrder);
+  // The real-only transform works in place and needs room for the interleaved complex output
+  std::vector<float> buffer((size_t)mWindowSize * 2);
+  const int numBins = mWindowSize / 2;
+  for (int frame = startFrame; frame < startFrame + numFrames; ++frame) {
+    const int start = frame * mHopSize;
+    const int numSamples = juce::jmin(mWindowSize, numInputSamples - start);
+    juce::FloatVectorOperations::multiply(buffer.data(), input + start, mWindow.data(), numSamples);
+    std::fill(buffer.begin() + numSamples, buffer.end(), 0.0f);
+
+    fft.performRealOnlyForwardTransform(buffer.data(), true);
 
-    curSample += mHopSize;
-    if (curSample > numInputSamples) {
-      hasData = false;
+    float* out = mFftData[(size_t)frame];
+    for (int bin = 0; bin < numBins; ++bin) {
+      const float re = buffer[(size_t)bin * 2];
+      const float im = buffer[(size_t)bin * 2 + 1];
+      out[bin] = std::sqrt(re * re + im * im);
     }
   }
-
-  return &mFftData;
 }
@@ -16,6 +16,7 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
 #include "Utils/DSP.h"
+#include "Utils/TaskGraph.h"
 
 class Fft {
  public:
@@ -24,20 +25,24 @@ class Fft {
 
   void clear(bool clearData);
 
+  // Magnitudes of the first channel, a frame every hop with the last ones zero padded, normalized 0.0-1.0 over all frames
   Utils::SpecBuffer* process(const juce::AudioBuffer<float>* audioBuffer);
   Utils::SpecBuffer* getSpectrum() { return &mFftData; }
 
  private:
-  // pointer to buffer to read from
-  const juce::AudioBuffer<float>* mInputBuffer = nullptr;
+  // Frames are split in tasks of this many, each with its own FFT as not every FFT engine is thread safe
+  static constexpr int FRAMES_PER_TASK = 64;
+
+  void processFrames(const float* input, int numInputSamples, int startFrame, int numFrames);
 
   // values passed in at creation time
   int mWindowSize;
   int mHopSize;
-  juce::dsp::FFT mForwardFFT;
-  juce::dsp::WindowingFunction<float> mWindowEnvelope;
+  int mOrder;
+  std::vector<float> mWindow;
+
+  juce::SharedResourcePointer<Utils::SharedThreadPool> mPool;
 
   // processed data
-  std::vector<float> mFftFrame;
   Utils::SpecBuffer mFftData;  // FFT data normalized from 0.0-1.0
 };
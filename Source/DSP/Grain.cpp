@@ -10,14 +10,14 @@
 
 #include "Grain.h"
 
-float Grain::process(float chanPerc, const juce::AudioBuffer<float>& audioBuffer, float envelopeGain, int time) {
+float Grain::process(float chanPerc, const Utils::SampleBuffer::View& samples, float envelopeGain, int time) {
+  if (time < trigTs) return 0.0f;  // Beat locked grains can start later in the block
   const float timePerc = static_cast<float>((time - trigTs)) / duration;
 
   // Panning gain
   const float panGain = computeChannelPanningGain(chanPerc);
 
   const float totalGain = envelopeGain * panGain * getAmplitude(timePerc);
-  const float* fileBuf = audioBuffer.getReadPointer(0);
 
   const float sampleIdx = duration * pbRate * timePerc;
   int lowSample = std::floor(sampleIdx);
@@ -26,13 +26,13 @@ float Grain::process(float chanPerc, const juce::AudioBuffer<float>& audioBuffer
   if (pbRate < 0.0f) {
     std::swap(lowSample, highSample);
     rem = fabsf(lowSample - sampleIdx);
-    lowSample += audioBuffer.getNumSamples();
-    highSample += audioBuffer.getNumSamples();
+    lowSample += samples.numSamples;
+    highSample += samples.numSamples;
   }
 
   // Some quick interpolation between sample values
-  float sample = juce::jmap(rem, fileBuf[(startPos + lowSample) % audioBuffer.getNumSamples()],
-                            fileBuf[(startPos + highSample) % audioBuffer.getNumSamples()]);
+  float sample = juce::jmap(rem, samples[(startPos + lowSample) % samples.numSamples],
+                            samples[(startPos + highSample) % samples.numSamples]);
 
   sample *= totalGain;
   return sample;
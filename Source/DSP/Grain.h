@@ -11,6 +11,7 @@
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
 #include "Utils/Envelope.h"
+#include "Utils/SampleBuffer.h"
 
 class Grain {
  public:
@@ -28,7 +29,7 @@ class Grain {
   }
   
 
-  float process(float chanPerc, const juce::AudioBuffer<float>& audioBuffer, float gain, int time);
+  float process(float chanPerc, const Utils::SampleBuffer::View& samples, float gain, int time);
 
   int duration;  // Grain duration in samples
   float pbRate;  // Playback rate (1.0 being regular speed, -1.0 being regular speed in reverse)
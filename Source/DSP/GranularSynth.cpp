@@ -14,6 +14,8 @@
 #include "Preset.h"
 #include "Utils/Files.h"
 #include "Utils/Presets.h"
+#include "Utils/AudioCodec.h"
+#include "Utils/MappedAudioBuffer.h"
 #include "PluginEditor.h"
 #include "Components/Settings.h"
 
@@ -35,8 +37,7 @@ mFft(FFT_SIZE, HOP_SIZE) {
   
   Utils::FILE_RECENT_FILES.create(); // Creates recent files if it doesn't exist
 
-  mParameters.note.addParams(*this);
-  mParameters.global.addParams(*this);
+  mParameters.addParams(*this);
 
   mTotalSamps = 0;
   mProcessedSpecs.fill(nullptr);
@@ -46,15 +47,16 @@ mFft(FFT_SIZE, HOP_SIZE) {
   mFormatManager.registerBasicFormats();
 
   mReferenceTone.setAmplitude(0.0f);
+  mReadAheadThread.startThread();
 
   mParameters.resetParams();
 
-  juce::MemoryBlock block;
-  Utils::getBlockForPreset(Utils::PRESETS[0], block);
-  loadPreset(block);
+  loadPreset(Utils::PRESETS[0].data, (size_t)Utils::PRESETS[0].size);
 }
 
 GranularSynth::~GranularSynth() {
+  cancelLoad();
+  mLoadPool.removeAllJobs(true, 10000);
   stopThread(10000);
 }
 
@@ -104,57 +106,162 @@ const juce::String GranularSynth::getProgramName(int) { return {}; }
 void GranularSynth::changeProgramName(int, const juce::String&) {}
 
 void GranularSynth::run() {
-  // Resample the audio buffer for feeding into the pitch detector
-  Utils::resampleAudioBuffer(mAudioBuffer, mDownsampledAudio, mSampleRate, BASIC_PITCH_SAMPLE_RATE);
-
-  // Then use BasicPitch ML to extract note events
-  mPitchDetector.transcribeToMIDI(mDownsampledAudio.getWritePointer(0),
-                                  mDownsampledAudio.getNumSamples());
+  if (!mIsTranscriptionOnly) analyze();
+
+  // Note detection changed while the notes were made, make them again until it stops changing
+  while (true) {
+    {
+      const juce::ScopedLock lock(mTranscriptionLock);
+      if (!mTranscriptionPending || !mHasAnalysis || threadShouldExit()) {
+        mIsAnalysisThreadBusy = false;
+        return;
+      }
+      mTranscriptionPending = false;
+    }
+    updateNotes();
+  }
+}
 
-  if (threadShouldExit()) return;
+void GranularSynth::analyze() {
+  {
+    // The notes about to be made are from the current note detection settings
+    const juce::ScopedLock lock(mTranscriptionLock);
+    mTranscriptionPending = false;
+  }
+  applyTranscriptionParams();
+  {
+    // Anything made for the last audio is stale, and mPitchSpecBuffer is about to be written
+    const juce::ScopedLock lock(mPitchSpecLock);
+    mHasPendingPitchSpec = false;
+  }
 
-  createCandidates(); // Create candidates from MIDI events
+  // Packed audio is only unpacked for as long as the analysis runs
+  juce::AudioBuffer<float> unpackedAudio;
+  juce::AudioBuffer<float>& audioBuffer = getFloatAudioBuffer(unpackedAudio);
+
+  const bool isFeatureSpecs = Utils::getSpecsFromFeatures();
+  mPitchDetector.setMakeFeatureSpecs(isFeatureSpecs);
+
+  // Same audio analyzed before, only the candidates have to be made again
+  const juce::File cacheFile = getAnalysisCacheFile(audioBuffer, isFeatureSpecs);
+  {
+    juce::MemoryMappedFile cached(cacheFile, juce::MemoryMappedFile::readOnly);
+    const juce::ScopedLock lock(mChunkCacheLock);
+    if (cached.getData() != nullptr && readAnalysis(cached.getData(), cached.getSize())) {
+      Utils::touchAnalysisCacheFile(cacheFile);
+      // The cached notes are used as they are, unless they were made with other note detection settings
+      if (!isNoteDetectionCurrent()) {
+        applyTranscriptionParams();
+        mPitchDetector.updateMIDI();
+      }
+      makePitchSpec(mPitchSpecBuffer);
+      mAnalysisVersion++;
+      createCandidates();
+      mParameters.ui.specComplete = false;  // Make arc spec render the specs into images
+      return;
+    }
+  }
 
-  if (threadShouldExit()) return;
+  // The transcription branch and the spectrogram branch don't depend on each other, so they run side by side
+  Utils::TaskGraph graph;
+  // Then use BasicPitch ML to extract note events, the audio is resampled for it a block at a time and each block is
+  // transcribed as soon as it's there
+  const auto transcribe = graph.add(
+      [&]() {
+        mPitchDetector.beginTranscription();
+        const bool isResampled = Utils::resampleAudioStream(
+            audioBuffer.getReadPointer(0), audioBuffer.getNumSamples(), mSampleRate, BASIC_PITCH_SAMPLE_RATE,
+            [&](const float* samples, int numSamples) {
+              mPitchDetector.pushAudio(samples, (size_t)numSamples);
+              return !graph.isCancelled();
+            });
+        if (isResampled) {
+          const juce::ScopedLock lock(mChunkCacheLock);
+          mPitchDetector.endTranscription();
+        }
+      },
+      {}, 0.65f);
+  graph.add(
+      [&]() {
+        // Create candidates from MIDI events
+        const juce::ScopedLock lock(mChunkCacheLock);
+        createCandidates();
+      },
+      {transcribe}, 0.05f);
+  graph.add(
+      [&]() {
+        makePitchSpec(mPitchSpecBuffer);
+        mProcessedSpecs[ParamUI::SpecType::DETECTED] = &mPitchSpecBuffer;
+      },
+      {transcribe}, 0.05f);
+  if (isFeatureSpecs) {
+    // The spectrogram and harmonic profile come out of the transcription's CQT, no need for another pass over the audio
+    graph.add(
+        [&]() {
+          mPitchDetector.takeFeatureSpecs(*mFft.getSpectrum(), *mHPCP.getHPCP());
+          mProcessedSpecs[ParamUI::SpecType::SPECTROGRAM] = mFft.getSpectrum();
+          mProcessedSpecs[ParamUI::SpecType::HPCP] = mHPCP.getHPCP();
+        },
+        {transcribe}, 0.01f);
+  } else {
+    // Meanwhile, calc FFT and HPCP
+    const auto fft = graph.add([&]() { mProcessedSpecs[ParamUI::SpecType::SPECTROGRAM] = mFft.process(&audioBuffer); }, {}, 0.15f);
+    graph.add([&]() { mProcessedSpecs[ParamUI::SpecType::HPCP] = mHPCP.process(mFft.getSpectrum(), mSampleRate); }, {fft}, 0.1f);
+  }
 
-  // Finally, calc FFT and HPCP
-  mProcessedSpecs[ParamUI::SpecType::SPECTROGRAM] = mFft.process(&mAudioBuffer);
-  mProcessedSpecs[ParamUI::SpecType::HPCP] = mHPCP.process(mFft.getSpectrum(), mSampleRate);
-  makePitchSpec();
-  mProcessedSpecs[ParamUI::SpecType::DETECTED] = &mPitchSpecBuffer;
+  mAnalysisProgress = 0.0f;
+  const bool isComplete = graph.run(
+      mWorkerPool->pool, [this]() { return threadShouldExit(); }, [this](float progress) { mAnalysisProgress = progress; });
+  mAnalysisProgress = -1.0f;
+  if (!isComplete) return;
 
-  if (threadShouldExit()) return;
+  mHasAnalysis = true;
+  mAnalysisVersion++;
+  mParameters.ui.isSpecLogFrequency = isFeatureSpecs;
 
   //mPitchDetector.reset();
 
   mParameters.ui.specComplete = false; // Make arc spec render the specs into images
   // Arc spec turns off isLoading once images are rendered as well
+
+  juce::MemoryOutputStream analysis;
+  if (writeAnalysis(analysis)) {
+    Utils::addAnalysisCacheFile(cacheFile, analysis.getData(), analysis.getDataSize());
+  }
 }
 
 //==============================================================================
 void GranularSynth::prepareToPlay(double sampleRate, int samplesPerBlock) {
-  // Make a temporary buffer copy for resampling
-  if (mInputBuffer.getNumSamples() > 0) {
-    // Resample input buffer (untrimmed)
-    juce::AudioSampleBuffer inputBuffer = mInputBuffer;
-    Utils::resampleAudioBuffer(inputBuffer, mInputBuffer, mSampleRate, sampleRate);
-  }
-  if (mAudioBuffer.getNumSamples() > 0) {
-    // Resample main buffer
-    juce::AudioSampleBuffer inputBuffer = mAudioBuffer;
-    Utils::resampleAudioBuffer(inputBuffer, mAudioBuffer, mSampleRate, sampleRate);
+  // Resample main buffer, only when the rate changed as hosts call this again for all kinds of reasons
+  if (sampleRate != mSampleRate) {
+    juce::AudioBuffer<float> unpackedAudio;
+    juce::AudioBuffer<float>& audioBuffer = getFloatAudioBuffer(unpackedAudio);
+    if (audioBuffer.getNumSamples() > 0) {
+      juce::AudioBuffer<float> buffer;
+      std::unique_ptr<Utils::MappedAudioBuffer> mapping;
+      Utils::resampleAudioBuffer(audioBuffer, buffer, mapping, mSampleRate, sampleRate);
+      swapAudioBuffer(buffer, mapping);
+    }
   }
 
-  mSampleRate = sampleRate;
+  {
+    const juce::ScopedLock lock(mChunkCacheLock);
+    mSampleRate = sampleRate;
+    mAudioVersion++;
+  }
   
   const juce::dsp::ProcessSpec filtConfig = {sampleRate, (juce::uint32)samplesPerBlock, (unsigned int)getTotalNumOutputChannels()};
   mMeterSource.resize(getTotalNumOutputChannels(), sampleRate * 0.1 / samplesPerBlock);
   mReferenceTone.prepareToPlay(samplesPerBlock, sampleRate);
+  mInputTransport.prepareToPlay(samplesPerBlock, sampleRate);
+  mInputPlaybackSample = -1;
   mParameters.prepareModSources(samplesPerBlock, sampleRate);
+  mTransport.prepare(sampleRate);
 }
 
 void GranularSynth::releaseResources() {
   mReferenceTone.releaseResources();
+  mInputTransport.releaseResources();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -185,6 +292,16 @@ void GranularSynth::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuf
   auto totalNumOutputChannels = getTotalNumOutputChannels();
   const int bufferNumSample = buffer.getNumSamples();
 
+  // Only pass on host tempo changes when there are any
+  const int transportChanges = mTransport.update(getPlayHead(), bufferNumSample);
+  if (transportChanges & (Utils::Transport::TEMPO | Utils::Transport::TIME_SIGNATURE)) {
+    mBarsPerSec = (float)mTransport.getSecPerBar();
+    for (auto& lfo : mParameters.global.modLFOs) {
+      lfo.setSyncRate(mBarsPerSec);
+    }
+  }
+  if (transportChanges != Utils::Transport::NONE) mResnapSyncedGrains = true;
+
   // Update mod source values once per block
   mParameters.processModSources();
 
@@ -213,20 +330,26 @@ void GranularSynth::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuf
   // Reference tone
   mReferenceTone.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, 0, buffer.getNumSamples()));
 
-  // Playback from trim selection panel
+  // Loads only hold it to swap in a new buffer, so this never waits for long
+  const juce::SpinLock::ScopedLockType audioBufferLock(mAudioBufferLock);
+  mGrainSamples = mPackedAudio.isEmpty() ? Utils::SampleBuffer::getView(mAudioBuffer) : mPackedAudio.getView();
+
+  // Playback from trim selection panel, streamed from the input file
   if (mParameters.ui.playingTrimSelection) {
-    int numPlaybackSamples = bufferNumSample;
-    if (mParameters.ui.trimPlaybackSample + bufferNumSample >= mInputBuffer.getNumSamples()) {
+    const double inputLength = mCanPlayInput ? mInputTransport.getLengthInSeconds() * mSampleRate : 0.0;
+    if (mParameters.ui.trimPlaybackSample + bufferNumSample >= inputLength) {
       // Done playing, reset status
       mParameters.ui.playingTrimSelection = false;
     } else {
-      // if output buffer is stereo and the input in mono, duplicate into both channels
-      // if output buffer is mono and the input in stereo, just play one channel for simplicity
-      for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
-        const int inputChannel = juce::jmin(ch, mInputBuffer.getNumChannels() - 1);
-        buffer.copyFrom(ch, 0, mInputBuffer, inputChannel, mParameters.ui.trimPlaybackSample, numPlaybackSamples);
+      // The UI sets the sample to play from, otherwise the transport is already there
+      if (mParameters.ui.trimPlaybackSample != mInputPlaybackSample) {
+        mInputTransport.setPosition(mParameters.ui.trimPlaybackSample / mSampleRate);
       }
-      mParameters.ui.trimPlaybackSample += numPlaybackSamples;
+      if (!mInputTransport.isPlaying()) mInputTransport.start();
+      // A mono file is played in both channels
+      mInputTransport.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, 0, bufferNumSample));
+      mParameters.ui.trimPlaybackSample += bufferNumSample;
+      mInputPlaybackSample = mParameters.ui.trimPlaybackSample;
     }
   }
 
@@ -243,18 +366,18 @@ void GranularSynth::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuf
       // Add contributions from the grains in this generator
       for (size_t genIdx = 0; genIdx < NUM_GENERATORS; ++genIdx) {
         ParamGenerator* paramGenerator = mParameters.note.notes[gNote->pitchClass]->generators[genIdx].get();
-        const float gain = juce::Decibels::decibelsToGain(mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GAIN, true));
-        const float attack = mParameters.getFloatParam(mParameters.global.ampEnvAttack, true);
-        const float decay = mParameters.getFloatParam(mParameters.global.ampEnvDecay, true);
-        const float sustain = juce::Decibels::decibelsToGain(mParameters.getFloatParam(mParameters.global.ampEnvSustain, true));
-        const float release = mParameters.getFloatParam(mParameters.global.ampEnvRelease, true);
+        const float gain = juce::Decibels::decibelsToGain(mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GAIN, true, gNote->voice));
+        const float attack = mParameters.getFloatParam(mParameters.global.ampEnvAttack, true, gNote->voice);
+        const float decay = mParameters.getFloatParam(mParameters.global.ampEnvDecay, true, gNote->voice);
+        const float sustain = juce::Decibels::decibelsToGain(mParameters.getFloatParam(mParameters.global.ampEnvSustain, true, gNote->voice));
+        const float release = mParameters.getFloatParam(mParameters.global.ampEnvRelease, true, gNote->voice);
         const float grainGain =
             gNote->genAmpEnvs[genIdx].getAmplitude(mTotalSamps, attack * mSampleRate, decay * mSampleRate, sustain,
                                                   release * mSampleRate) * gain * velocityGain;
         for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
           float genSample = 0.0f;
           for (Grain* grain : gNote->genGrains[genIdx]) {
-            genSample += grain->process(ch / (float)(buffer.getNumChannels() - 1), mAudioBuffer, grainGain, mTotalSamps);
+            genSample += grain->process(ch / (float)(buffer.getNumChannels() - 1), mGrainSamples, grainGain, mTotalSamps);
           }
           bufferChannels[ch][i] += genSample;
         }
@@ -267,22 +390,6 @@ void GranularSynth::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuf
   for (int i = 0; i < buffer.getNumChannels(); i++) {
     juce::FloatVectorOperations::clip(buffer.getWritePointer(i), buffer.getReadPointer(i), -1.0f, 1.0f, bufferNumSample);
   }
-  
-  double bpm = DEFAULT_BPM;
-  int beatsPerBar = DEFAULT_BEATS_PER_BAR;
-  if (juce::AudioPlayHead* playhead = getPlayHead()) {
-    if (playhead->getPosition()->getBpm()) {
-      bpm = *(playhead->getPosition()->getBpm());
-    }
-    if (playhead->getPosition()->getTimeSignature()) {
-      beatsPerBar = playhead->getPosition()->getTimeSignature()->numerator;
-    }
-  }
-  // Update sync rate of lfos
-  mBarsPerSec = (1.0f / bpm) * 60.0f * beatsPerBar;
-  for (auto& lfo : mParameters.global.modLFOs) {
-    lfo.setSyncRate(mBarsPerSec);
-  }
 
   handleGrainAddRemove(bufferNumSample);
 
@@ -328,59 +435,67 @@ void GranularSynth::setStateInformation(const void* data, int sizeInBytes) {
     return;  // reloadPluginState() can try loading old/bad/stale info and crash at launch
   }
 
-  juce::MemoryBlock block(data, sizeInBytes);
-  Utils::Result r = loadPreset(block);
+  Utils::Result r = loadPreset(data, (size_t)sizeInBytes);
   if (!r.success) DBG(juce::String("Error during getStateInformation(): ") + r.message);
+  // The parameter list can't change once the host has it, so the editor tells the user instead
+  if (r.success && mParameters.getRegistry().isRestoredLayoutMissing()) mIsHostLayoutMissing = true;
 }
 
 // These are slightly different then the get/setStateInformation. These are for
 // 'user params' which include items that are related to audio, but not actually
 // juce::AudioParam items that the DAW can use
 void GranularSynth::getPresetParamsXml(juce::MemoryBlock& destData) {
+  const juce::ScopedLock lock(mChunkCacheLock);
+  destData = getParamsChunk();
+}
+
+const juce::MemoryBlock& GranularSynth::getParamsChunk() {
+  // Writing out the ~1000 parameter values is the slow part, the rest is small enough to build and compare every time
+  std::unique_ptr<juce::XmlElement> notesXml(mParameters.note.getXml());
+  std::unique_ptr<juce::XmlElement> uiXml(mParameters.ui.getXml());
+  std::unique_ptr<juce::XmlElement> modulationsXml(mParameters.getModulationsXml());
+  std::unique_ptr<juce::XmlElement> hostSlotsXml(mParameters.getRegistry().getHostSlotsXml());
+  const auto format = juce::XmlElement::TextFormat().singleLine().withoutHeader();
+  const juce::String state = notesXml->toString(format) + uiXml->toString(format) + modulationsXml->toString(format) +
+                             hostSlotsXml->toString(format);
+
+  const juce::uint32 paramsVersion = mParameters.getParamsVersion();
+  if (mParamsChunk.isCurrent(paramsVersion) && state == mParamsChunkState) {
+    return mParamsChunk.data;
+  }
+
   juce::XmlElement xml("UserState");
 
   juce::XmlElement* audioParams = new juce::XmlElement("AudioParams");
-  for (auto& param : getParameters()) {
+  // Includes parameters not given to the host in compact mode
+  for (auto& param : mParameters.getAllParams()) {
     audioParams->setAttribute(ParamHelper::getParamID(param), param->getValue());
   }
   xml.addChildElement(audioParams);
-  xml.addChildElement(mParameters.note.getXml());
-  xml.addChildElement(mParameters.ui.getXml());
-  xml.addChildElement(mParameters.getModulationsXml());
-
-  copyXmlToBinary(xml, destData);
+  xml.addChildElement(notesXml.release());
+  xml.addChildElement(uiXml.release());
+  xml.addChildElement(modulationsXml.release());
+  xml.addChildElement(hostSlotsXml.release());
+
+  copyXmlToBinary(xml, mParamsChunk.data);
+  mParamsChunk.setCurrent(paramsVersion);
+  mParamsChunkState = state;
+  return mParamsChunk.data;
 }
 
 // Sets parameters based on memory stored in a preset
 void GranularSynth::setPresetParamsXml(const void* data, int sizeInBytes) {
-  // Reset all params and candidates
-  mParameters.resetParams();
-  mParameters.note.clearCandidates();
+  // Candidates are replaced by the NotesParams, the generator candidate params are restored with the rest
+  for (auto& note : mParameters.note.notes) {
+    note->candidates.clear();
+  }
 
   auto xml = getXmlFromBinary(data, sizeInBytes);
-  if (xml != nullptr) {
-    auto params = xml->getChildByName("AudioParams");
-    if (params != nullptr) {
-      for (auto& param : getParameters()) {
-        param->setValueNotifyingHost(params->getDoubleAttribute(ParamHelper::getParamID(param), param->getValue()));
-      }
-    }
+  // Restore as one batch instead of notifying the host and UI for each of the ~1000 params, missing params are reset
+  mParameters.restoreParams(xml != nullptr ? xml->getChildByName("AudioParams") : nullptr);
 
-    // Set isUsed for each common parameter based on param values
-    for (int i = 0; i < ParamCommon::Type::NUM_COMMON; ++i) {
-      for (auto& note: mParameters.note.notes) {
-        if (note->common[i]->getValue() != COMMON_RANGES[i].convertTo0to1(COMMON_DEFAULTS[i])) {
-          note->isUsed[i] = true;
-        }
-        for (auto& gen : note->generators) {
-          if (gen->common[i]->getValue() != COMMON_RANGES[i].convertTo0to1(COMMON_DEFAULTS[i])) {
-            gen->isUsed[i] = true;
-          }
-        }
-      }
-    }
-
-    params = xml->getChildByName("NotesParams");
+  if (xml != nullptr) {
+    auto params = xml->getChildByName("NotesParams");
     if (params != nullptr) {
       mParameters.note.setXml(params);
     }
@@ -395,6 +510,8 @@ void GranularSynth::setPresetParamsXml(const void* data, int sizeInBytes) {
       mParameters.setModulationsXml(params);
     }
   }
+  // Which parameters the host slots drive belongs to the session, not to this machine
+  mParameters.getRegistry().setHostSlotsXml(xml != nullptr ? xml->getChildByName("HostSlots") : nullptr);
 }
 
 //==============================================================================
@@ -422,22 +539,37 @@ void GranularSynth::handleGrainAddRemove(int blockSize) {
     // Add one grain per active note
     for (GrainNote* gNote : mActiveNotes) {
       for (size_t i = 0; i < gNote->grainTriggers.size(); ++i) {
-        if (gNote->grainTriggers[i] <= 0) {
-          ParamGenerator* paramGenerator = mParameters.note.notes[gNote->pitchClass]->generators[i].get();
+        ParamGenerator* paramGenerator = mParameters.note.notes[gNote->pitchClass]->generators[i].get();
+        const bool grainSync = mParameters.getBoolParam(paramGenerator, ParamCommon::Type::GRAIN_SYNC);
+        // Synced grains follow the host's beat grid while it's playing
+        const bool isBeatLocked = grainSync && mTransport.isPlaying();
+        double syncIntervalPpq = 0.0;
+        if (isBeatLocked) {
+          const float grainRate = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_RATE, true, gNote->voice);
+          const float div = std::pow(2, juce::roundToInt(ParamRanges::SYNC_DIV_MAX * ParamRanges::GRAIN_RATE.convertTo0to1(grainRate)));
+          syncIntervalPpq = mTransport.getPpqPerBar() / div;
+          // Tempo or position changed, the next grain is wherever the grid is now (the first grain of a note isn't delayed)
+          if (mResnapSyncedGrains && gNote->grainTriggers[i] >= 0) {
+            gNote->grainTriggers[i] = mTransport.getSamplesToGrid(syncIntervalPpq, blockSize) - blockSize;
+          }
+        }
+        // Triggers count down to the start of the next block, beat locked grains are placed exactly within it
+        const bool isDue = isBeatLocked ? gNote->grainTriggers[i] < blockSize : gNote->grainTriggers[i] <= 0;
+        if (isDue) {
+          const int trigOffset = isBeatLocked ? juce::jmax(0, (int)gNote->grainTriggers[i]) : 0;
           ParamCandidate* paramCandidate = mParameters.note.notes[gNote->pitchClass]->getCandidate(i);
           float durSec;
-          const float gain = juce::Decibels::decibelsToGain(mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GAIN, true));
-          const float grainRate = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_RATE, true);
-          const float grainDuration = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_DURATION, true);
-          const bool grainSync = mParameters.getBoolParam(paramGenerator, ParamCommon::Type::GRAIN_SYNC);
-          const float pitchAdjust = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PITCH_ADJUST, true);
-          const float pitchSpray = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PITCH_SPRAY, true);
-          const float posAdjust = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::POS_ADJUST, true);
-          const float posSpray = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::POS_SPRAY, true);
-          const float panAdjust = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PAN_ADJUST, true);
-          const float panSpray = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PAN_SPRAY, true);
-          const float shape = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_SHAPE, true);
-          const float tilt = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_TILT, true);
+          const float gain = juce::Decibels::decibelsToGain(mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GAIN, true, gNote->voice));
+          const float grainRate = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_RATE, true, gNote->voice);
+          const float grainDuration = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_DURATION, true, gNote->voice);
+          const float pitchAdjust = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PITCH_ADJUST, true, gNote->voice);
+          const float pitchSpray = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PITCH_SPRAY, true, gNote->voice);
+          const float posAdjust = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::POS_ADJUST, true, gNote->voice);
+          const float posSpray = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::POS_SPRAY, true, gNote->voice);
+          const float panAdjust = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PAN_ADJUST, true, gNote->voice);
+          const float panSpray = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::PAN_SPRAY, true, gNote->voice);
+          const float shape = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_SHAPE, true, gNote->voice);
+          const float tilt = mParameters.getFloatParam(paramGenerator, ParamCommon::Type::GRAIN_TILT, true, gNote->voice);
           const bool reverse = mParameters.getBoolParam(paramGenerator, ParamCommon::Type::REVERSE);
           const float octaveAdjust = mParameters.getIntParam(paramGenerator, ParamCommon::Type::OCTAVE_ADJUST);
 
@@ -459,7 +591,7 @@ void GranularSynth::handleGrainAddRemove(int blockSize) {
               float posSprayOffset = juce::jmap(random.nextFloat(), ParamRanges::POSITION_SPRAY.start, posSpray) * mSampleRate;
               if (random.nextFloat() > 0.5f) posSprayOffset = -posSprayOffset;
               float posOffset = posAdjust * durSamples + posSprayOffset;
-              float posSamples = paramCandidate->posRatio * mAudioBuffer.getNumSamples() + posOffset;
+              float posSamples = paramCandidate->posRatio * mGrainSamples.numSamples + posOffset;
 
               /* Pan offset */
               float panSprayOffset = random.nextFloat() * panSpray;
@@ -480,16 +612,26 @@ void GranularSynth::handleGrainAddRemove(int blockSize) {
               jassert(paramCandidate->pbRate > 0.1f);
 
               /* Add grain */
-              grain->set(durSamples, pbRate, posSamples, mTotalSamps, gain, panOffset, shape, tilt);
+              grain->set(durSamples, pbRate, posSamples, mTotalSamps + trigOffset, gain, panOffset, shape, tilt);
               gNote->genGrains[i].add(grain);
 
+              // Streamed from disk, keep the area the following grains of this candidate will read from in memory
+              if (mAudioMapping != nullptr) {
+                const float reach = posSpray * mSampleRate + std::abs(durSamples * pbRate);
+                const float center = paramCandidate->posRatio * mGrainSamples.numSamples + posAdjust * durSamples;
+                mAudioMapping->addHint(static_cast<int>(center - reach), static_cast<int>(2.0f * reach));
+              }
+
               /* Trigger grain in arcspec */
               float totalGain = gain * gNote->genAmpEnvs[i].amplitude;
               mParameters.note.grainCreated(gNote->pitchClass, i, durSec / pbRate, totalGain);
             }
           }
           // Reset trigger ts
-          if (grainSync) {
+          if (isBeatLocked) {
+            // Next grid position after this grain rather than adding the interval, so it doesn't drift from the host
+            gNote->grainTriggers[i] = mTransport.getSamplesToGrid(syncIntervalPpq, blockSize + trigOffset + 1) - blockSize;
+          } else if (grainSync) {
             float div = std::pow(2, juce::roundToInt(ParamRanges::SYNC_DIV_MAX * ParamRanges::GRAIN_RATE.convertTo0to1(grainRate)));
             float rateSec = mBarsPerSec / div;
             // Find synced rate interval using bpm
@@ -504,6 +646,7 @@ void GranularSynth::handleGrainAddRemove(int blockSize) {
       }
     }
   }
+  mResnapSyncedGrains = false;
   // Delete expired grains
   mGrainPool.reclaimExpiredGrains(mTotalSamps);
   for (GrainNote* gNote : mActiveNotes) {
@@ -531,107 +674,447 @@ void GranularSynth::handleGrainAddRemove(int blockSize) {
         break;  // will only be at most 1 note (TODO assuming mouse and midi aren't set at same time)
       }
     }
+    mParameters.voiceMods.freeVoice(gNote->voice);
     mActiveNotes.removeObject(gNote);
   }
 }
 
 Utils::Result GranularSynth::loadAudioFile(juce::File file) {
-  juce::AudioFormatReader* formatReader = mFormatManager.createReaderFor(file);
-  if (formatReader == nullptr) return {false, "Opening failed: unsupported file format"};
+  std::unique_ptr<juce::AudioFormatReader> reader = openAudioFile(file);
+  if (reader == nullptr) return {false, "Opening failed: unsupported file format"};
+  publishInputFile(file, std::move(reader));
+  return {true, ""};
+}
+
+std::unique_ptr<juce::AudioFormatReader> GranularSynth::openAudioFile(juce::File file) {
+  // WAV and AIFF are read straight from a mapping of the file, so only the pages that are played or trimmed are touched
+  if (juce::AudioFormat* format = mFormatManager.findFormatForFileExtension(file.getFileExtension())) {
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format->createMemoryMappedReader(file));
+    if (mappedReader != nullptr && mappedReader->mapEntireFile()) return mappedReader;
+  }
+  // Anything compressed is decoded on demand by its reader
+  return std::unique_ptr<juce::AudioFormatReader>(mFormatManager.createReaderFor(file));
+}
+
+Utils::Result GranularSynth::readAudioRange(juce::AudioFormatReader& reader, bool isMp3, juce::Range<juce::int64> range,
+                                            juce::AudioBuffer<float>& buffer, std::unique_ptr<Utils::MappedAudioBuffer>& mapping,
+                                            double sampleRate, const LoadProgress& progress) {
+  range = range.getIntersectionWith({0, reader.lengthInSamples});
 
+  // Decode, the first half of the progress. A long selection goes to disk instead of memory, as does the resampled result
   juce::AudioBuffer<float> fileAudioBuffer;
-  const int length = static_cast<int>(formatReader->lengthInSamples);
-  fileAudioBuffer.setSize(1, length);
-  formatReader->read(&fileAudioBuffer, 0, length, 0, true, false);
+  std::unique_ptr<Utils::MappedAudioBuffer> fileMapping;
+  const int length = static_cast<int>(range.getLength());
+  Utils::allocateAudioBuffer(fileAudioBuffer, fileMapping, 1, length, reader.sampleRate);
+  for (int start = 0; start < length; start += LOAD_BLOCK_SAMPLES) {
+    const int numSamples = juce::jmin(LOAD_BLOCK_SAMPLES, length - start);
+    reader.read(&fileAudioBuffer, start, numSamples, range.getStart() + start, true, false);
+    if (progress && !progress(0.5f * (start + numSamples) / length)) return {false, "Loading was cancelled"};
+  }
 
   // .mp3 files, unlike .wav files, can contain PCM values greater than abs(1.0) (aka, clipping) which will produce awful
-  // sounding grains, so normalize the gain of any mp3 file clipping before using anywhere
-  if (file.getFileExtension() == ".mp3") {
+  // sounding grains, so normalize the gain of any mp3 selection clipping before using anywhere
+  if (isMp3) {
     float absMax = 0.0f;
     for (int i = 0; i < fileAudioBuffer.getNumChannels(); i++) {
-      juce::Range<float> range =
+      juce::Range<float> minMax =
           juce::FloatVectorOperations::findMinAndMax(fileAudioBuffer.getReadPointer(i), fileAudioBuffer.getNumSamples());
-      absMax = juce::jmax(absMax, std::abs(range.getStart()), std::abs(range.getEnd()));
+      absMax = juce::jmax(absMax, std::abs(minMax.getStart()), std::abs(minMax.getEnd()));
     }
     if (absMax > 1.0) {
       fileAudioBuffer.applyGain(1.0f / absMax);
     }
   }
 
-  Utils::resampleAudioBuffer(fileAudioBuffer, mInputBuffer, formatReader->sampleRate, mSampleRate);
-  
-  // should not need the file anymore as we want to work with the resampled input buffer across the rest of the plugin
-  delete (formatReader);
-
+  // Resample, the second half
+  const bool isResampled =
+      Utils::resampleAudioBuffer(fileAudioBuffer, buffer, mapping, reader.sampleRate, sampleRate, true,
+                                 [&progress](float value) { return !progress || progress(0.5f + 0.5f * value); });
+  if (!isResampled) return {false, "Loading was cancelled"};
   return {true, ""};
 }
 
 Utils::Result GranularSynth::loadPreset(juce::File file) {
+  PresetData preset;
+  Utils::Result r = openPreset(file, preset);
+  if (!r.success) return r;
+  preset.sampleRate = mSampleRate;
+  r = readPreset(preset.data, preset.size, preset, nullptr);
+  if (r.success) {
+    applyPreset(preset);
+    setLoadedPresetFile(file);
+  }
+  return r;
+}
+
+Utils::Result GranularSynth::loadPreset(const void* presetData, size_t presetSize) {
+  PresetData preset;
+  preset.sampleRate = mSampleRate;
+  Utils::Result r = readPreset(presetData, presetSize, preset, nullptr);
+  if (r.success) applyPreset(preset);
+  return r;
+}
+
+void GranularSynth::loadAudioFileAsync(juce::File file, std::function<void(Utils::Result)> onDone) {
+  // Only opening happens here, some readers (mp3) scan the whole file to find their length
+  auto reader = std::make_shared<std::unique_ptr<juce::AudioFormatReader>>();
+  startLoad(
+      [this, file, reader](const LoadProgress&) -> Utils::Result {
+        *reader = openAudioFile(file);
+        if (*reader == nullptr) return {false, "Opening failed: unsupported file format"};
+        return {true, ""};
+      },
+      [this, file, reader, onDone](Utils::Result r) {
+        if (r.success) publishInputFile(file, std::move(*reader));
+        if (onDone) onDone(r);
+      });
+}
+
+void GranularSynth::loadPresetAsync(juce::File file, std::function<void(Utils::Result)> onDone) {
+  auto preset = std::make_shared<PresetData>();
+  preset->sampleRate = mSampleRate;
+  startLoad(
+      [this, file, preset](const LoadProgress& progress) {
+        Utils::Result r = openPreset(file, *preset);
+        return r.success ? readPreset(preset->data, preset->size, *preset, progress) : r;
+      },
+      [this, file, preset, onDone](Utils::Result r) {
+        if (r.success) {
+          applyPreset(*preset);
+          setLoadedPresetFile(file);
+        }
+        if (onDone) onDone(r);
+      });
+}
+
+void GranularSynth::cancelLoad() {
+  if (mLoadCancelled != nullptr) mLoadCancelled->store(true);
+  mIsFileLoading = false;
+}
+
+void GranularSynth::startLoad(std::function<Utils::Result(const LoadProgress&)> load,
+                              std::function<void(Utils::Result)> publish) {
+  // Only the latest load is published, anything still running stops at its next progress report
+  cancelLoad();
+  auto isCancelled = std::make_shared<std::atomic<bool>>(false);
+  mLoadCancelled = isCancelled;
+  mLoadProgress = 0.0f;
+  mIsFileLoading = true;
+
+  juce::WeakReference<GranularSynth> weakThis(this);
+  mLoadPool.addJob([this, weakThis, isCancelled, load, publish]() {
+    const LoadProgress progress = [this, isCancelled](float value) {
+      mLoadProgress = value;
+      return !isCancelled->load();
+    };
+    const Utils::Result r = load(progress);
+    juce::MessageManager::callAsync([weakThis, isCancelled, publish, r]() {
+      // Cancelled or the synth is gone while this was waiting for the message thread
+      if (weakThis == nullptr || isCancelled->load()) return;
+      weakThis->mIsFileLoading = false;
+      publish(r);
+    });
+    return juce::ThreadPoolJob::jobHasFinished;
+  });
+}
+
+void GranularSynth::publishAudioBuffer(juce::AudioBuffer<float>& buffer, std::unique_ptr<Utils::MappedAudioBuffer>& mapping,
+                                       double sampleRate) {
+  // The device rate changed while loading
+  if (sampleRate != mSampleRate) {
+    juce::AudioBuffer<float> resampled;
+    std::unique_ptr<Utils::MappedAudioBuffer> resampledMapping;
+    Utils::resampleAudioBuffer(buffer, resampled, resampledMapping, sampleRate, mSampleRate);
+    std::swap(buffer, resampled);
+    std::swap(mapping, resampledMapping);
+  }
+  swapAudioBuffer(buffer, mapping);
+}
+
+void GranularSynth::swapAudioBuffer(juce::AudioBuffer<float>& buffer, std::unique_ptr<Utils::MappedAudioBuffer>& mapping) {
+  // Audio streamed from disk is already out of memory, it stays float
+  Utils::SampleBuffer packed;
+  if (mapping == nullptr && Utils::getCompactAudio()) {
+    packed.pack(buffer);
+    buffer.setSize(0, 0);
+  }
+  {
+    // A state save encodes the buffer under mChunkCacheLock, it sees either the old buffer and version or the new ones
+    const juce::ScopedLock chunkLock(mChunkCacheLock);
+    const juce::SpinLock::ScopedLockType lock(mAudioBufferLock);
+    std::swap(mAudioBuffer, buffer);
+    std::swap(mAudioMapping, mapping);
+    std::swap(mPackedAudio, packed);
+    mAudioVersion++;
+  }
+  // The old buffer can point into the old mapping, drop both before the file goes away
+  if (mapping != nullptr) mReadAheadThread.removeTimeSliceClient(mapping.get());
+  buffer.setSize(0, 0);
+  mapping.reset();
+  if (mAudioMapping != nullptr) mReadAheadThread.addTimeSliceClient(mAudioMapping.get());
+  updateReadAheadHints();
+}
+
+void GranularSynth::updateReadAheadHints() {
+  if (mAudioMapping == nullptr) return;
+  // Grains start within the position spray of a candidate and read about a grain duration of it
+  const int numSamples = mAudioBuffer.getNumSamples();
+  const int spray = static_cast<int>(ParamRanges::POSITION_SPRAY.end * mSampleRate);
+  std::vector<juce::Range<int>> ranges;
+  for (auto& note : mParameters.note.notes) {
+    for (const ParamCandidate& candidate : note->candidates) {
+      const int reach = spray + static_cast<int>(ParamRanges::GRAIN_DURATION.end * mSampleRate / candidate.pbRate);
+      const int position = static_cast<int>(candidate.posRatio * numSamples);
+      ranges.push_back({position - reach, position + reach});
+    }
+  }
+  mAudioMapping->setPinnedHints(std::move(ranges));
+}
+
+void GranularSynth::publishInputFile(juce::File file, std::unique_ptr<juce::AudioFormatReader> reader) {
+  closeInputFile();
+  mInputFile = file;
+  mInputReader = std::move(reader);
+  mInputSource = std::make_unique<juce::AudioFormatReaderSource>(mInputReader.get(), false);
+  mInputTransport.setSource(mInputSource.get(), LOAD_BLOCK_SAMPLES, &mReadAheadThread, mInputReader->sampleRate, 2);
+  mInputTransport.start();
+  const juce::SpinLock::ScopedLockType lock(mAudioBufferLock);
+  mCanPlayInput = true;
+  mInputPlaybackSample = -1;
+}
+
+void GranularSynth::closeInputFile() {
+  {
+    // Once this is released the audio thread is done with the transport
+    const juce::SpinLock::ScopedLockType lock(mAudioBufferLock);
+    mCanPlayInput = false;
+    mParameters.ui.playingTrimSelection = false;
+  }
+  mInputTransport.setSource(nullptr);
+  mInputSource.reset();
+  mInputReader.reset();
+  mInputFile = juce::File();
+}
+
+Utils::Result GranularSynth::openPreset(juce::File file, PresetData& preset) {
+  // Parsed straight from the mapping, only the audio gets copied (or resampled) out of it
+  preset.mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+  if (preset.mappedFile->getData() != nullptr) {
+    preset.data = preset.mappedFile->getData();
+    preset.size = preset.mappedFile->getSize();
+    return {true, ""};
+  }
+  preset.mappedFile.reset();
+
   juce::FileInputStream input(file);
-  if (input.openedOk()) {
-    juce::MemoryBlock block;
-    input.readIntoMemoryBlock(block);
-    Utils::Result r = loadPreset(block);
-    if (r.success) {
-      mParameters.ui.fileName = file.getFileName();
-      mParameters.ui.loadedFileName = mParameters.ui.fileName;
-      Utils::addRecentFile(file.getFullPathName()); // Save recent file to list
-    }
-    return r;
-  } else {
+  if (!input.openedOk()) {
     juce::String error = "The file failed to open with message: " + input.getStatus().getErrorMessage();
     return {false, error};
   }
+  input.readIntoMemoryBlock(preset.fileData);
+  preset.data = preset.fileData.getData();
+  preset.size = preset.fileData.getSize();
+  return {true, ""};
 }
 
-Utils::Result GranularSynth::loadPreset(juce::MemoryBlock& block) {
-  int curBlockPos = 0;
-  Preset::Header header;
-  block.copyTo(&header, curBlockPos, sizeof(header));
-  curBlockPos += sizeof(header);
+void GranularSynth::setLoadedPresetFile(juce::File file) {
+  mParameters.ui.fileName = file.getFileName();
+  mParameters.ui.loadedFileName = mParameters.ui.fileName;
+  Utils::addRecentFile(file.getFullPathName()); // Save recent file to list
+}
+
+// 16 bit samples are saved as they are, unpacking them to floats would double the size for nothing
+static void writeInt16Audio(juce::OutputStream& out, const Utils::SampleBuffer::View& samples) {
+  juce::GZIPCompressorOutputStream zip(out, Utils::AudioCodec::COMPRESSION_LEVEL);
+  zip.write(samples.ints, (size_t)samples.numSamples * sizeof(int16_t));
+  zip.flush();
+}
+
+static bool readInt16Audio(const void* data, size_t size, float scale, juce::AudioBuffer<float>& buffer) {
+  juce::MemoryInputStream in(data, size, false);
+  juce::GZIPDecompressorInputStream unzip(in);
+  std::vector<int16_t> block(1 << 14);
+  float* dest = buffer.getWritePointer(0);
+  for (int start = 0; start < buffer.getNumSamples(); start += (int)block.size()) {
+    const int numSamples = juce::jmin((int)block.size(), buffer.getNumSamples() - start);
+    const int blockSize = numSamples * (int)sizeof(int16_t);
+    if (unzip.read(block.data(), blockSize) != blockSize) return false;
+    for (int i = 0; i < numSamples; ++i) dest[start + i] = static_cast<float>(block[(size_t)i]) * scale;
+  }
+  return true;
+}
 
-  if (header.magic != Preset::MAGIC) {
+Utils::Result GranularSynth::readPreset(const void* presetData, size_t presetSize, PresetData& preset,
+                                        const LoadProgress& progress) {
+  const uint8_t* data = static_cast<const uint8_t*>(presetData);
+  Preset::VersionHeader version;
+  if (presetSize < sizeof(version)) {
     return {false, "The file is not recognized as a valid .gbow preset file."};
   }
+  std::memcpy(&version, data, sizeof(version));
 
+  if (version.magic != Preset::MAGIC) {
+    return {false, "The file is not recognized as a valid .gbow preset file."};
+  }
+
+  // Either refers to the raw samples in the preset data or owns decoded ones
   juce::AudioBuffer<float> fileAudioBuffer;
   double sampleRate;
+  bool isDecodedInPlace = false;  // Already in preset.audioBuffer
+  std::vector<float*> channels;
+  auto referToSamples = [&](const uint8_t* samples, int numChannels, int numSamples) {
+    if (reinterpret_cast<uintptr_t>(samples) % alignof(float) != 0) {
+      // Can't point at unaligned floats, copy them instead
+      fileAudioBuffer.setSize(numChannels, numSamples);
+      for (int ch = 0; ch < numChannels; ++ch) {
+        std::memcpy(fileAudioBuffer.getWritePointer(ch), samples + (size_t)ch * numSamples * sizeof(float),
+                    (size_t)numSamples * sizeof(float));
+      }
+      return;
+    }
+    channels.resize((size_t)numChannels);
+    for (int ch = 0; ch < numChannels; ++ch) {
+      // Only ever read from, the buffer is just the interface the resampler takes
+      channels[(size_t)ch] = const_cast<float*>(reinterpret_cast<const float*>(samples)) + (size_t)ch * numSamples;
+    }
+    fileAudioBuffer.setDataToReferTo(channels.data(), numChannels, numSamples);
+  };
+
+  if (version.versionMajor == 0) {
+    size_t curBlockPos = 0;
+    Preset::Header header;
+    if (presetSize < sizeof(header)) {
+      return {false, "The .gbow file is truncated or corrupted."};
+    }
+    std::memcpy(&header, data, sizeof(header));
+    curBlockPos += sizeof(header);
 
-  // Currently there is only a VERSION_MAJOR of 0
-  if (header.versionMajor == 0) {
     // Get Audio Buffer blob
-    fileAudioBuffer.setSize(header.audioBufferChannel, header.audioBufferNumberOfSamples);
-    block.copyTo(fileAudioBuffer.getWritePointer(0), curBlockPos, header.audioBufferSize);
+    const size_t imagesSize = (size_t)header.specImageSpectrogramSize + (size_t)header.specImageHpcpSize +
+                              (size_t)header.specImageDetectedSize;
+    if (header.audioBufferChannel < 0 || header.audioBufferNumberOfSamples < 0 ||
+        (size_t)header.audioBufferSize <
+            (size_t)header.audioBufferChannel * (size_t)header.audioBufferNumberOfSamples * sizeof(float) ||
+        presetSize - curBlockPos < (size_t)header.audioBufferSize + imagesSize) {
+      return {false, "The .gbow file is truncated or corrupted."};
+    }
+    referToSamples(data + curBlockPos, header.audioBufferChannel, header.audioBufferNumberOfSamples);
     curBlockPos += header.audioBufferSize;
     sampleRate = header.audioBufferSamplerRate;
 
     // The image data is saved in the XML, for backward compatibility might need to ignore duplciated image data
-    curBlockPos += header.specImageSpectrogramSize;
-    curBlockPos += header.specImageHpcpSize;
-    curBlockPos += header.specImageDetectedSize;
+    curBlockPos += imagesSize;
 
     // juce::FileInputStream uses 'int' to read
-    int xmlSize = static_cast<int>(block.getSize() - curBlockPos);
-    void* xmlData = malloc(xmlSize);
-    jassert(xmlData != nullptr);
-    block.copyTo(xmlData, curBlockPos, xmlSize);
-    curBlockPos += xmlSize;
-    setPresetParamsXml(xmlData, xmlSize);
-    mParameters.ui.specComplete = true;
-    free(xmlData);
+    preset.paramsXml = data + curBlockPos;
+    preset.paramsXmlSize = static_cast<int>(presetSize - curBlockPos);
+  } else if (version.versionMajor == 1) {
+    std::vector<Preset::ChunkInfo> chunks;
+    if (!Preset::readChunks(data, presetSize, chunks)) {
+      return {false, "The .gbow file is truncated or corrupted."};
+    }
+
+    const Preset::ChunkInfo* audioChunk = Preset::findChunk(chunks, Preset::CHUNK_AUDIO);
+    Preset::AudioChunk audio;
+    if (audioChunk == nullptr || audioChunk->size < sizeof(audio)) {
+      return {false, "The .gbow file has no audio."};
+    }
+    std::memcpy(&audio, data + audioChunk->offset, sizeof(audio));
+    const uint8_t* audioData = data + audioChunk->offset + sizeof(audio);
+    const size_t audioDataSize = (size_t)(audioChunk->size - sizeof(audio));
+    const uint64_t rawAudioSize = (uint64_t)audio.numSamples * (uint64_t)audio.numChannels * sizeof(float);
+    // Compressed audio can't claim more samples than its data can expand to, checked before anything is allocated
+    const uint64_t maxDecodedSize = (uint64_t)audioDataSize * MAX_COMPRESSED_EXPANSION;
+    const uint64_t maxInt16Samples = maxDecodedSize / sizeof(int16_t);
+    if (audio.numSamples < 0 || audio.numChannels < 0 || audio.numChannels > MAX_PRESET_CHANNELS ||
+        (audio.encoding == Preset::AUDIO_FLOAT32 && audioDataSize < rawAudioSize) ||
+        (audio.encoding == Preset::AUDIO_FLOAT32_PACKED && rawAudioSize > maxDecodedSize) ||
+        (audio.encoding == Preset::AUDIO_INT16 && (audio.numChannels != 1 || (uint64_t)audio.numSamples > maxInt16Samples)) ||
+        (audio.encoding != Preset::AUDIO_FLOAT32 && audio.encoding != Preset::AUDIO_FLOAT32_PACKED &&
+         audio.encoding != Preset::AUDIO_INT16)) {
+      return {false, "The .gbow file audio is in an unknown format or corrupted."};
+    }
+    sampleRate = audio.sampleRate;
+
+    // Decoded audio at the synth's rate goes straight into the buffer the synth takes over, without a copy
+    auto getDecodeBuffer = [&](int numChannels) -> juce::AudioBuffer<float>& {
+      if (sampleRate != preset.sampleRate) {
+        fileAudioBuffer.setSize(numChannels, audio.numSamples);
+        return fileAudioBuffer;
+      }
+      Utils::allocateAudioBuffer(preset.audioBuffer, preset.audioMapping, numChannels, audio.numSamples, sampleRate);
+      isDecodedInPlace = true;
+      return preset.audioBuffer;
+    };
+    if (audio.encoding == Preset::AUDIO_FLOAT32_PACKED) {
+      if (!Utils::AudioCodec::decode(audioData, audioDataSize, getDecodeBuffer(audio.numChannels))) {
+        return {false, "The .gbow file audio is corrupted."};
+      }
+    } else if (audio.encoding == Preset::AUDIO_INT16) {
+      // Packed again by publishAudioBuffer() when 16 bit samples are on, which gives back the same samples
+      if (!readInt16Audio(audioData, audioDataSize, audio.scale, getDecodeBuffer(1))) {
+        return {false, "The .gbow file audio is corrupted."};
+      }
+    } else {
+      referToSamples(audioData, audio.numChannels, audio.numSamples);
+    }
+
+    if (const Preset::ChunkInfo* chunk = Preset::findChunk(chunks, Preset::CHUNK_PARAMS)) {
+      preset.paramsXml = data + chunk->offset;
+      preset.paramsXmlSize = static_cast<int>(chunk->size);
+    }
+    if (const Preset::ChunkInfo* chunk = Preset::findChunk(chunks, Preset::CHUNK_IMAGES)) {
+      preset.images = data + chunk->offset;
+      preset.imagesSize = (size_t)chunk->size;
+    }
+    if (const Preset::ChunkInfo* chunk = Preset::findChunk(chunks, Preset::CHUNK_ANALYSIS)) {
+      preset.analysis = data + chunk->offset;
+      preset.analysisSize = (size_t)chunk->size;
+    }
   } else {
-    juce::String error = "The file is .gbow version " + juce::String(header.versionMajor) + "." +
-                          juce::String(header.versionMinor) +
+    juce::String error = "The file is .gbow version " + juce::String(version.versionMajor) + "." +
+                          juce::String(version.versionMinor) +
                           " and is not supported. This copy of gRainbow can open files up to version " +
                           juce::String(Preset::VERSION_MAJOR) + "." + juce::String(Preset::VERSION_MINOR);
     return {false, error};
   }
+  if (progress && !progress(0.5f)) return {false, "Loading was cancelled"};
+
+  // The synth owns its buffer as it is written to later (trim, clear), but it's only one copy out of the preset
+  if (isDecodedInPlace) {
+    return {true, ""};
+  } else if (sampleRate == preset.sampleRate) {
+    Utils::allocateAudioBuffer(preset.audioBuffer, preset.audioMapping, fileAudioBuffer.getNumChannels(),
+                               fileAudioBuffer.getNumSamples(), sampleRate);
+    preset.audioBuffer.makeCopyOf(fileAudioBuffer);
+  } else if (!Utils::resampleAudioBuffer(fileAudioBuffer, preset.audioBuffer, preset.audioMapping, sampleRate,
+                                         preset.sampleRate, false,
+                                         [&progress](float value) { return !progress || progress(0.5f + 0.5f * value); })) {
+    return {false, "Loading was cancelled"};
+  }
+  return {true, ""};
+}
+
+void GranularSynth::applyPreset(PresetData& preset) {
+  // An analysis still running would replace the candidates and specs the preset restores
+  stopThread(10000);
+
+  {
+    // The candidates and notes are replaced, a state save could be reading them
+    const juce::ScopedLock lock(mChunkCacheLock);
+    // Params first as they reset the UI state the images belong to, anything else is not needed to play the preset
+    if (preset.paramsXml != nullptr) setPresetParamsXml(preset.paramsXml, preset.paramsXmlSize);
+    if (preset.images != nullptr) mParameters.ui.readSpecImages(preset.images, preset.imagesSize);
+    mParameters.ui.specComplete = true;
+    // Optional, the preset plays without it but the audio has to be analyzed again to re-transcribe or re-render the specs
+    if (preset.analysis == nullptr || !readAnalysis(preset.analysis, preset.analysisSize)) {
+      resetAnalysis();
+    }
+  }
 
-  mInputBuffer.clear();
-  mAudioBuffer.clear();
-  Utils::resampleAudioBuffer(fileAudioBuffer, mAudioBuffer, sampleRate, mSampleRate);
+  closeInputFile();
+  publishAudioBuffer(preset.audioBuffer, preset.audioMapping, preset.sampleRate);
   jassert(!mParameters.ui.isLoading);
-  return {true, ""};
 }
 
 Utils::Result GranularSynth::savePreset(juce::File file) {
@@ -652,59 +1135,136 @@ Utils::Result GranularSynth::savePreset(juce::File file) {
 }
 
 Utils::Result GranularSynth::savePreset(juce::MemoryBlock& block) {
-  Preset::Header header;
-  header.magic = Preset::MAGIC;
-  header.versionMajor = Preset::VERSION_MAJOR;
-  header.versionMinor = Preset::VERSION_MINOR;
+  // Only what changed since the last save is encoded again, the versions are read first so a change made while encoding
+  // is picked up by the next save. The audio buffer and its version only change under this lock (see swapAudioBuffer())
+  const juce::ScopedLock lock(mChunkCacheLock);
+  Preset::AudioChunk audio = {};
   // Audio buffer data is grabbed from current synth
-  header.audioBufferSamplerRate = mSampleRate;
-  header.audioBufferNumberOfSamples = mAudioBuffer.getNumSamples();
-  header.audioBufferChannel = mAudioBuffer.getNumChannels();
-  header.audioBufferSize = header.audioBufferNumberOfSamples * header.audioBufferChannel * sizeof(float);
+  audio.sampleRate = mSampleRate;
+  const bool isPacked = !mPackedAudio.isEmpty();
+  audio.numSamples = isPacked ? mPackedAudio.getNumSamples() : mAudioBuffer.getNumSamples();
+  audio.numChannels = isPacked ? 1 : mAudioBuffer.getNumChannels();
+  audio.encoding = isPacked ? Preset::AUDIO_INT16 : Preset::AUDIO_FLOAT32_PACKED;
+  audio.scale = isPacked ? mPackedAudio.getView().scale : 1.0f;
+
+  const juce::uint32 audioVersion = mAudioVersion.load();
+  if (!mAudioChunk.isCurrent(audioVersion)) {
+    juce::MemoryOutputStream audioStream(mAudioChunk.data, false);
+    if (isPacked) {
+      writeInt16Audio(audioStream, mPackedAudio.getView());
+    } else {
+      Utils::AudioCodec::encode(mAudioBuffer, audioStream);
+    }
+    audioStream.flush();
+    mAudioChunk.setCurrent(audioVersion);
+  }
+
+  const juce::uint32 analysisVersion = mAnalysisVersion.load();
+  if (!mAnalysisChunk.isCurrent(analysisVersion)) {
+    // Left empty when there is no analysis to save
+    juce::MemoryOutputStream analysisStream(mAnalysisChunk.data, false);
+    writeAnalysis(analysisStream);
+    analysisStream.flush();
+    mAnalysisChunk.setCurrent(analysisVersion);
+  }
 
-  // For backward compatibility keep values and just have them be zero
-  header.specImageSpectrogramSize = 0;
-  header.specImageHpcpSize = 0;
-  header.specImageDetectedSize = 0;
+  const juce::uint32 imagesVersion = mParameters.ui.specImagesVersion.load();
+  if (!mImagesChunk.isCurrent(imagesVersion)) {
+    juce::MemoryOutputStream imagesStream(mImagesChunk.data, false);
+    mParameters.ui.writeSpecImages(imagesStream);
+    imagesStream.flush();
+    mImagesChunk.setCurrent(imagesVersion);
+  }
 
   // XML structure of preset contains all audio related information
   // These include not just AudioParams but also other params not exposes to
   // the DAW or UI directly
-  juce::MemoryBlock xmlMemoryBlock;
-  getPresetParamsXml(xmlMemoryBlock);
+  const juce::MemoryBlock& xmlMemoryBlock = getParamsChunk();
+
+  // Each chunk is an optional small header followed by its data
+  struct ChunkData {
+    uint32_t type;
+    const void* head;
+    size_t headSize;
+    const void* data;
+    size_t dataSize;
+  };
+  std::vector<ChunkData> chunkData;
+  chunkData.push_back({Preset::CHUNK_AUDIO, &audio, sizeof(audio), mAudioChunk.data.getData(), mAudioChunk.data.getSize()});
+  if (mAnalysisChunk.data.getSize() > 0) {
+    chunkData.push_back({Preset::CHUNK_ANALYSIS, nullptr, 0, mAnalysisChunk.data.getData(), mAnalysisChunk.data.getSize()});
+  }
+  chunkData.push_back({Preset::CHUNK_IMAGES, nullptr, 0, mImagesChunk.data.getData(), mImagesChunk.data.getSize()});
+  chunkData.push_back({Preset::CHUNK_PARAMS, nullptr, 0, xmlMemoryBlock.getData(), xmlMemoryBlock.getSize()});
+
+  Preset::HeaderV1 header = {};
+  header.magic = Preset::MAGIC;
+  header.versionMajor = Preset::VERSION_MAJOR;
+  header.versionMinor = Preset::VERSION_MINOR;
+  header.numChunks = (uint32_t)chunkData.size();
+
+  std::vector<Preset::ChunkInfo> chunks;
+  uint64_t offset = sizeof(header) + chunkData.size() * sizeof(Preset::ChunkInfo);
+  for (const ChunkData& chunk : chunkData) {
+    offset = (offset + Preset::CHUNK_ALIGNMENT - 1) / Preset::CHUNK_ALIGNMENT * Preset::CHUNK_ALIGNMENT;
+    chunks.push_back({chunk.type, 0, offset, chunk.headSize + chunk.dataSize});
+    offset += chunks.back().size;
+  }
 
   // Write data out section by section
-  juce::MemoryOutputStream blockStream(block, true);
+  juce::MemoryOutputStream blockStream(block, false);
+  block.ensureSize((size_t)offset);
   blockStream.write(&header, sizeof(header));
-  if (mAudioBuffer.getNumSamples() > 0) {
-    blockStream.write(reinterpret_cast<const void*>(mAudioBuffer.getReadPointer(0)), header.audioBufferSize);
+  blockStream.write(chunks.data(), chunks.size() * sizeof(Preset::ChunkInfo));
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    blockStream.writeRepeatedByte(0, (size_t)chunks[i].offset - (size_t)blockStream.getPosition());
+    if (chunkData[i].headSize > 0) blockStream.write(chunkData[i].head, chunkData[i].headSize);
+    blockStream.write(chunkData[i].data, chunkData[i].dataSize);
   }
-  blockStream.write(xmlMemoryBlock.getData(), xmlMemoryBlock.getSize());
   blockStream.flush();
 
   return {true, ""};
 }
 
-void GranularSynth::trimAndExtractPitches(juce::Range<double> range) {
-  mParameters.ui.playingTrimSelection = false;
+void GranularSynth::trimAndExtractPitches(juce::Range<double> range, std::function<void(Utils::Result)> onDone) {
+  if (mInputReader == nullptr) {
+    if (onDone) onDone({false, "No audio file to trim"});
+    return;
+  }
   mParameters.ui.trimRange = range;
 
-  // Trim
-  const double sampleLength = static_cast<double>(mInputBuffer.getNumSamples());
-  const double secondLength = sampleLength / mSampleRate;
-  juce::int64 start = static_cast<juce::int64>(sampleLength * (range.getStart() / secondLength));
-  juce::int64 end = static_cast<juce::int64>(sampleLength * (range.getEnd() / secondLength));
-  Utils::trimAudioBuffer(mInputBuffer, mAudioBuffer, juce::Range<juce::int64>(start, end));
-  mInputBuffer.clear();
-  
-  // Extract pitches
-  stopThread(10000);
-  mParameters.ui.isLoading = false;
-  mProcessedSpecs.fill(nullptr);
-  mParameters.ui.isLoading = true;
-  mParameters.note.clearCandidates();
-  mParameters.setSelectedParams(&mParameters.global);
-  startThread();
+  // The load owns the reader from here on, so the trim playback has to let go of it first
+  const bool isMp3 = mInputFile.getFileExtension() == ".mp3";
+  const double fileSampleRate = mInputReader->sampleRate;
+  const juce::Range<juce::int64> sampleRange(static_cast<juce::int64>(range.getStart() * fileSampleRate),
+                                             static_cast<juce::int64>(range.getEnd() * fileSampleRate));
+  std::shared_ptr<juce::AudioFormatReader> reader(std::move(mInputReader));
+  closeInputFile();
+
+  auto buffer = std::make_shared<juce::AudioBuffer<float>>();
+  auto mapping = std::make_shared<std::unique_ptr<Utils::MappedAudioBuffer>>();
+  const double sampleRate = mSampleRate;
+  startLoad(
+      [this, reader, isMp3, sampleRange, buffer, mapping, sampleRate](const LoadProgress& progress) {
+        return readAudioRange(*reader, isMp3, sampleRange, *buffer, *mapping, sampleRate, progress);
+      },
+      [this, buffer, mapping, sampleRate, onDone](Utils::Result r) {
+        if (r.success) {
+          // The analysis reads mAudioBuffer, stop it before replacing it
+          stopThread(10000);
+          publishAudioBuffer(*buffer, *mapping, sampleRate);
+
+          // Extract pitches
+          mHasAnalysis = false;
+          mAnalysisVersion++;
+          mProcessedSpecs.fill(nullptr);
+          mParameters.ui.isLoading = true;
+          mParameters.note.clearCandidates();
+          mParameters.setSelectedParams(&mParameters.global);
+          startAnalysisThread(false);
+        }
+        if (onDone) onDone(r);
+      });
 }
 
 std::vector<ParamCandidate*> GranularSynth::getActiveCandidates() {
@@ -725,14 +1285,18 @@ void GranularSynth::handleNoteOn(juce::MidiKeyboardState*, int, int midiNoteNumb
   if (foundNote == mActiveNotes.end()) {
     // New note, start 'er up
     mMidiNotes.add(Utils::MidiNote(mLastPitchClass, velocity));
-    mActiveNotes.add(new GrainNote(midiNoteNumber, velocity, mTotalSamps));
+    GrainNote* gNote = new GrainNote(midiNoteNumber, velocity, mTotalSamps);
+    gNote->voice = mParameters.voiceMods.allocateVoice();
+    mParameters.voiceMods.noteOn(gNote->voice);
+    mActiveNotes.add(gNote);
   } else {
     // Already playing note, just reset the envelope
     (*foundNote)->velocity = velocity;
     (*foundNote)->noteOn(mTotalSamps);
+    mParameters.voiceMods.noteOn((*foundNote)->voice);
   }
 
-  // Retrigger modulators
+  // Retrigger the global modulators, the audio uses the per-voice state but the UI follows the last note played
   for (auto& lfo : mParameters.global.modLFOs) {
     lfo.checkRetrigger();
   }
@@ -751,6 +1315,7 @@ void GranularSynth::handleNoteOff(juce::MidiKeyboardState*, int, int midiNoteNum
       for (size_t i = 0; i < NUM_GENERATORS; ++i) {
         gNote->genAmpEnvs[i].noteOff(mTotalSamps);
       }
+      mParameters.voiceMods.noteOff(gNote->voice);
       gNote->removeTs = mTotalSamps + static_cast<int>(release * mSampleRate);
       break;
     }
@@ -761,8 +1326,246 @@ void GranularSynth::handleNoteOff(juce::MidiKeyboardState*, int, int midiNoteNum
   }
 }
 
-void GranularSynth::makePitchSpec() {
-  mPitchSpecBuffer.clear();
+// Specs are saved as 8 bit, plenty for drawing them
+static void writeQuantized(juce::OutputStream& out, const Utils::Matrix<float>& rows, float maxValue) {
+  const float scale = (maxValue > 0.0f) ? 255.0f / maxValue : 0.0f;
+  std::vector<uint8_t> row(rows.getNumCols());
+  for (size_t r = 0; r < rows.getNumRows(); ++r) {
+    for (size_t i = 0; i < row.size(); ++i) row[i] = (uint8_t)juce::jlimit(0, 255, juce::roundToInt(rows[r][i] * scale));
+    out.write(row.data(), row.size());
+  }
+}
+
+static bool readQuantized(juce::InputStream& in, Utils::Matrix<float>& rows, size_t numRows, size_t numBins, float maxValue) {
+  const float scale = maxValue / 255.0f;
+  rows.resize(numRows, numBins);
+  std::vector<uint8_t> row(numBins);
+  for (size_t r = 0; r < numRows; ++r) {
+    if (in.read(row.data(), (int)numBins) != (int)numBins) return false;
+    for (size_t i = 0; i < numBins; ++i) rows[r][i] = row[i] * scale;
+  }
+  return true;
+}
+
+// Posteriorgrams are saved as half floats, so notes made again from them match the ones made from the CNN output
+static void writeHalfFloats(juce::OutputStream& out, const Utils::Matrix<float>& rows) {
+  std::vector<uint16_t> row(rows.getNumCols());
+  for (size_t r = 0; r < rows.getNumRows(); ++r) {
+    for (size_t i = 0; i < row.size(); ++i) row[i] = Utils::floatToHalf(rows[r][i]);
+    out.write(row.data(), row.size() * sizeof(uint16_t));
+  }
+}
+
+static bool readHalfFloats(juce::InputStream& in, Utils::Matrix<float>& rows, size_t numRows, size_t numBins) {
+  rows.resize(numRows, numBins);
+  std::vector<uint16_t> row(numBins);
+  const int rowSize = (int)(numBins * sizeof(uint16_t));
+  for (size_t r = 0; r < numRows; ++r) {
+    if (in.read(row.data(), rowSize) != rowSize) return false;
+    for (size_t i = 0; i < numBins; ++i) rows[r][i] = Utils::halfToFloat(row[i]);
+  }
+  return true;
+}
+
+bool GranularSynth::writeAnalysis(juce::OutputStream& out) {
+  // DETECTED is made from the note events and WAVEFORM from the audio, so only these need saving
+  static constexpr std::array<ParamUI::SpecType, 2> SAVED_SPECS = {ParamUI::SpecType::SPECTROGRAM, ParamUI::SpecType::HPCP};
+  if (!mHasAnalysis) return false;
+
+  const std::vector<Notes::Event>& events = mPitchDetector.getNoteEvents();
+  Preset::AnalysisChunk chunk = {};
+  chunk.numFrames = (uint32_t)mPitchDetector.getContoursPG().getNumRows();
+  chunk.numEvents = (uint32_t)events.size();
+  chunk.numSpecs = (uint32_t)SAVED_SPECS.size();
+  chunk.noteSensitivity = mNoteDetection[0];
+  chunk.splitSensitivity = mNoteDetection[1];
+  chunk.minNoteLengthMs = mNoteDetection[2];
+  out.write(&chunk, sizeof(chunk));
+
+  juce::GZIPCompressorOutputStream zip(out, Utils::AudioCodec::COMPRESSION_LEVEL);
+  writeHalfFloats(zip, mPitchDetector.getOnsetsPG());
+  writeHalfFloats(zip, mPitchDetector.getNotesPG());
+  writeHalfFloats(zip, mPitchDetector.getContoursPG());
+  for (const Notes::Event& event : events) {
+    const Preset::EventInfo info = {event.startTime, event.endTime,  event.amplitude,
+                                    event.startFrame, event.endFrame, event.pitch, (int32_t)event.bends.size()};
+    zip.write(&info, sizeof(info));
+    for (int bend : event.bends) zip.writeShort((short)bend);
+  }
+  for (ParamUI::SpecType type : SAVED_SPECS) {
+    const Utils::SpecBuffer& spec = *mProcessedSpecs[type];
+    float maxValue = 0.0f;
+    for (size_t frame = 0; frame < spec.getNumRows(); ++frame) {
+      maxValue = juce::jmax(maxValue, juce::FloatVectorOperations::findMaximum(spec[frame], (int)spec.getNumCols()));
+    }
+    const Preset::SpecInfo info = {(uint32_t)type, (uint32_t)spec.getNumRows(), (uint32_t)spec.getNumCols(), maxValue};
+    zip.write(&info, sizeof(info));
+    writeQuantized(zip, spec, maxValue);
+  }
+  zip.flush();
+  return true;
+}
+
+bool GranularSynth::readAnalysis(const void* data, size_t size) {
+  Preset::AnalysisChunk chunk;
+  if (size < sizeof(chunk)) return false;
+  std::memcpy(&chunk, data, sizeof(chunk));
+  const size_t maxSize = (size - sizeof(chunk)) * MAX_COMPRESSED_EXPANSION;
+  if ((size_t)chunk.numFrames * (2 * NUM_FREQ_OUT + NUM_FREQ_IN) * sizeof(uint16_t) +
+          (size_t)chunk.numEvents * sizeof(Preset::EventInfo) >
+      maxSize) {
+    return false;
+  }
+
+  juce::MemoryInputStream in(static_cast<const uint8_t*>(data) + sizeof(chunk), size - sizeof(chunk), false);
+  juce::GZIPDecompressorInputStream unzip(in);
+  Utils::Matrix<float> onsets, notes, contours;
+  if (!readHalfFloats(unzip, onsets, chunk.numFrames, NUM_FREQ_OUT) ||
+      !readHalfFloats(unzip, notes, chunk.numFrames, NUM_FREQ_OUT) ||
+      !readHalfFloats(unzip, contours, chunk.numFrames, NUM_FREQ_IN)) {
+    return false;
+  }
+
+  std::vector<Notes::Event> events(chunk.numEvents);
+  for (Notes::Event& event : events) {
+    Preset::EventInfo info;
+    if (unzip.read(&info, sizeof(info)) != sizeof(info) || info.numBends < 0 ||
+        (size_t)info.numBends * sizeof(int16_t) > maxSize) {
+      return false;
+    }
+    event.startTime = info.startTime;
+    event.endTime = info.endTime;
+    event.amplitude = info.amplitude;
+    event.startFrame = info.startFrame;
+    event.endFrame = info.endFrame;
+    event.pitch = info.pitch;
+    event.bends.resize((size_t)info.numBends);
+    for (int& bend : event.bends) bend = unzip.readShort();
+    if (event.startFrame < 0 || event.endFrame > (int)chunk.numFrames || event.startFrame > event.endFrame) return false;
+  }
+
+  std::array<Utils::SpecBuffer, ParamUI::SpecType::COUNT> specs;
+  for (uint32_t i = 0; i < chunk.numSpecs; ++i) {
+    Preset::SpecInfo info;
+    if (unzip.read(&info, sizeof(info)) != sizeof(info) || info.specType >= specs.size() ||
+        (size_t)info.numFrames * info.numBins > maxSize ||
+        !readQuantized(unzip, specs[info.specType], info.numFrames, info.numBins, info.maxValue)) {
+      return false;
+    }
+  }
+  if (specs[ParamUI::SpecType::SPECTROGRAM].isEmpty() || specs[ParamUI::SpecType::HPCP].isEmpty()) return false;
+
+  mPitchDetector.setTranscription(std::move(contours), std::move(notes), std::move(onsets), std::move(events));
+  mNoteDetection = {chunk.noteSensitivity, chunk.splitSensitivity, chunk.minNoteLengthMs};
+  *mFft.getSpectrum() = std::move(specs[ParamUI::SpecType::SPECTROGRAM]);
+  *mHPCP.getHPCP() = std::move(specs[ParamUI::SpecType::HPCP]);
+  {
+    // Detected pitches made from the notes being replaced
+    const juce::ScopedLock lock(mPitchSpecLock);
+    mHasPendingPitchSpec = false;
+  }
+  makePitchSpec(mPitchSpecBuffer);
+  mProcessedSpecs[ParamUI::SpecType::SPECTROGRAM] = mFft.getSpectrum();
+  mProcessedSpecs[ParamUI::SpecType::HPCP] = mHPCP.getHPCP();
+  mProcessedSpecs[ParamUI::SpecType::DETECTED] = &mPitchSpecBuffer;
+  // Only the spectrogram made from the CQT has this many bins, the FFT one has half its window size
+  mParameters.ui.isSpecLogFrequency = mFft.getSpectrum()->getNumCols() == NUM_FREQ_IN;
+  mHasAnalysis = true;
+  mAnalysisVersion++;
+  return true;
+}
+
+juce::File GranularSynth::getAnalysisCacheFile(const juce::AudioBuffer<float>& audioBuffer, bool isFeatureSpecs) {
+  // The analysis runs on mAudioBuffer, so the same file at another sample rate is analyzed again
+  const juce::String key = juce::String::toHexString((juce::int64)Utils::hashAudioBuffer(audioBuffer)) + "_" +
+                           juce::String(juce::roundToInt(mSampleRate)) + (isFeatureSpecs ? "_cqt" : "") + "_v" +
+                           juce::String(ANALYSIS_CACHE_VERSION);
+  return Utils::getAnalysisCacheFile(key);
+}
+
+juce::AudioBuffer<float>& GranularSynth::getFloatAudioBuffer(juce::AudioBuffer<float>& scratch) {
+  if (mPackedAudio.isEmpty()) return mAudioBuffer;
+  mPackedAudio.unpack(scratch);
+  return scratch;
+}
+
+void GranularSynth::resetAnalysis() {
+  mPitchDetector.reset();
+  mProcessedSpecs.fill(nullptr);
+  mHasAnalysis = false;
+  mAnalysisVersion++;
+}
+
+void GranularSynth::updateTranscription() {
+  {
+    const juce::ScopedLock lock(mTranscriptionLock);
+    // A running analysis picks it up once it's done, without audio the next analysis uses the new settings anyways
+    mTranscriptionPending = true;
+    if (mIsAnalysisThreadBusy || !mHasAnalysis) return;
+  }
+  startAnalysisThread(true);
+}
+
+void GranularSynth::startAnalysisThread(bool isTranscriptionOnly) {
+  // run() clears mIsAnalysisThreadBusy right before it returns and startThread() does nothing until the thread is gone, so
+  // wait for it. It has nothing left to do by then, the wait is only bounded in case it is stuck. A pending transcription
+  // stays pending for the next try
+  if (!waitForThreadToExit(1000)) {
+    jassertfalse;
+    return;
+  }
+  const juce::ScopedLock lock(mTranscriptionLock);
+  jassert(!mIsAnalysisThreadBusy);  // A running analysis is stopped first, only the message thread starts one
+  mIsTranscriptionOnly = isTranscriptionOnly;
+  mIsAnalysisThreadBusy = true;
+  startThread();
+}
+
+void GranularSynth::applyTranscriptionParams() {
+  const juce::ScopedLock lock(mChunkCacheLock);  // A state save could be writing out mNoteDetection
+  mNoteDetection = {mParameters.ui.noteSensitivity.load(), mParameters.ui.splitSensitivity.load(),
+                    mParameters.ui.minNoteLengthMs.load()};
+  mPitchDetector.setParameters(mNoteDetection[0], mNoteDetection[1], mNoteDetection[2]);
+}
+
+bool GranularSynth::isNoteDetectionCurrent() const {
+  return mNoteDetection[0] == mParameters.ui.noteSensitivity.load() &&
+         mNoteDetection[1] == mParameters.ui.splitSensitivity.load() &&
+         mNoteDetection[2] == mParameters.ui.minNoteLengthMs.load();
+}
+
+void GranularSynth::updateNotes() {
+  // Only the notes are made again, the CNN output they come from is kept
+  applyTranscriptionParams();
+  {
+    // A state save could be writing out the notes and candidates
+    const juce::ScopedLock lock(mChunkCacheLock);
+    mPitchDetector.updateMIDI();
+    // Same audio, the generators keep the candidates they were on
+    createCandidates(true);
+  }
+  // mPitchSpecBuffer could be getting drawn, the editor swaps it in with publishPitchSpec()
+  Utils::SpecBuffer pitchSpec;
+  makePitchSpec(pitchSpec);
+  {
+    const juce::ScopedLock lock(mPitchSpecLock);
+    mPendingPitchSpec = std::move(pitchSpec);
+    mHasPendingPitchSpec = true;
+  }
+  mAnalysisVersion++;
+  mTranscriptionVersion++;
+}
+
+void GranularSynth::publishPitchSpec() {
+  const juce::ScopedLock lock(mPitchSpecLock);
+  if (!mHasPendingPitchSpec) return;
+  mPitchSpecBuffer.swap(mPendingPitchSpec);
+  mPendingPitchSpec.clear();
+  mHasPendingPitchSpec = false;
+}
+
+void GranularSynth::makePitchSpec(Utils::SpecBuffer& spec) {
+  spec.clear();
   const int numFrames = mPitchDetector.getNumFrames();
   const std::vector<Notes::Event>& events = mPitchDetector.getNoteEvents();
   // Find max and min pitches
@@ -772,24 +1575,23 @@ void GranularSynth::makePitchSpec() {
     if (evt.pitch < pitchRange.getStart() || pitchRange.getStart() == -1) pitchRange.setStart(evt.pitch);
   }
   // Init buffer size
-  for (size_t frame = 0; frame < numFrames; ++frame) {
-    mPitchSpecBuffer.emplace_back(std::vector<float>(pitchRange.getLength() + 1, 0.0f));
-  }
+  spec.resize((size_t)numFrames, (size_t)pitchRange.getLength() + 1);
   for (auto& evt : events) {
-    const int duration = (evt.endFrame - evt.startFrame);
-    for (float k = evt.startFrame; k < evt.endFrame; ++k) {
+    for (int k = evt.startFrame; k < evt.endFrame; ++k) {
       int pitchIdx = pitchRange.getLength() - (evt.pitch - pitchRange.getStart());
-      mPitchSpecBuffer[k][pitchIdx] = evt.amplitude;
+      spec[k][pitchIdx] = evt.amplitude;
     }
   }
 }
 
-void GranularSynth::createCandidates() {
+void GranularSynth::createCandidates(bool isKeepingPositions) {
   // Add candidates for each pitch class
   const std::vector<Notes::Event>& events = mPitchDetector.getNoteEvents();
   const int numFrames = mPitchDetector.getNumFrames();
+  std::array<std::vector<ParamCandidate>, Utils::PitchClass::COUNT> allCandidates;
   for (auto&& note : mParameters.note.notes) {
     // Look for detected pitches with correct pitch and good gain
+    std::vector<ParamCandidate>& candidates = allCandidates[(size_t)note->noteIdx];
     bool foundAll = false;
     int numFound = 0;
     int numSearches = 0;
@@ -808,7 +1610,7 @@ void GranularSynth::createCandidates() {
           int octave = evt.pitch / 12;
           float posRatio = (float)evt.startFrame / numFrames;
           float duration = (float)(evt.endFrame - evt.startFrame) / numFrames;
-          note->candidates.emplace_back(ParamCandidate(posRatio, octave, pbRate, duration, evt.amplitude));
+          candidates.emplace_back(ParamCandidate(posRatio, octave, pbRate, duration, evt.amplitude));
           numFound++;
           if (numFound >= MAX_CANDIDATES) {
             foundAll = true;
@@ -819,7 +1621,20 @@ void GranularSynth::createCandidates() {
       numSearches++;
       if (numSearches >= 6 || foundAll) break;
     }
+  }
 
-    note->setStartingCandidatePosition();
+  {
+    // The notes can be made again while playing, grains are only added under this lock. The old candidates are freed
+    // once it's released
+    const juce::SpinLock::ScopedLockType lock(mAudioBufferLock);
+    for (auto&& note : mParameters.note.notes) note->candidates.swap(allCandidates[(size_t)note->noteIdx]);
+  }
+  for (auto&& note : mParameters.note.notes) {
+    if (isKeepingPositions) {
+      note->keepCandidatePositions();
+    } else {
+      note->setStartingCandidatePosition();
+    }
   }
+  updateReadAheadHints();
 }
@@ -11,6 +11,8 @@
 #pragma once
 
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_audio_formats/juce_audio_formats.h>
 
 #include "Grain.h"
 #include "PitchDetection/BasicPitch.h"
@@ -20,9 +22,16 @@
 #include "Utils/Utils.h"
 #include "Utils/DSP.h"
 #include "Utils/MidiNote.h"
+#include "Utils/Transport.h"
+#include "Utils/SampleBuffer.h"
+#include "Utils/TaskGraph.h"
 #include <bitset>
 #include "ff_meters/ff_meters.h"
 
+namespace Utils {
+class MappedAudioBuffer;
+}
+
 class GranularSynth : public juce::AudioProcessor, public juce::MidiKeyboardState::Listener, public juce::Thread {
  public:
   static constexpr int MAX_GRAINS = 150;  // Max grains active at once
@@ -109,19 +118,53 @@ class GranularSynth : public juce::AudioProcessor, public juce::MidiKeyboardStat
 
   void getPresetParamsXml(juce::MemoryBlock& destData);
   void setPresetParamsXml(const void* data, int sizeInBytes);
+  // True once after the host restored a session saved with note and generator host params while they are compact here
+  bool takeHostLayoutMissing() { return mIsHostLayoutMissing.exchange(false); }
 
   double getSampleRate() { return mSampleRate; }
-  juce::AudioBuffer<float>& getAudioBuffer() { return mAudioBuffer; }
+  // The audio for the UI, float or packed, without a copy. Only valid until the next load or trim swaps the audio
+  Utils::SampleBuffer::View getAudioView() const {
+    return mPackedAudio.isEmpty() ? Utils::SampleBuffer::getView(mAudioBuffer) : mPackedAudio.getView();
+  }
   juce::MidiKeyboardState& getKeyboardState() { return mKeyboardState; }
   juce::AudioFormatManager& getFormatManager() { return mFormatManager; }
-  juce::AudioBuffer<float>& getInputBuffer() { return mInputBuffer; }
+  // The file waiting to be trimmed, it's only decoded for the trim playback and once the selection is made
+  juce::File getInputFile() const { return mInputFile; }
+  double getInputLengthSeconds() const {
+    return mInputReader == nullptr ? 0.0 : (double)mInputReader->lengthInSamples / mInputReader->sampleRate;
+  }
   Utils::Result loadAudioFile(juce::File file);
   Utils::Result loadPreset(juce::File file);
-  Utils::Result loadPreset(juce::MemoryBlock& fromBlock);
+  Utils::Result loadPreset(juce::MemoryBlock& fromBlock) { return loadPreset(fromBlock.getData(), fromBlock.getSize()); }
+  // Parses the preset in place, the data only has to stay valid for the duration of the call
+  Utils::Result loadPreset(const void* data, size_t size);
+
+  // Called with 0-1 as a load goes through its stages, returning false cancels it
+  using LoadProgress = std::function<bool(float)>;
+  // Same as the blocking versions, but decoding and resampling happen on a background thread and the audio keeps playing
+  // until the new buffer is swapped in. onDone is called on the message thread once the result is in use, or with the
+  // error. It isn't called if the load is cancelled, either by cancelLoad() or by starting another load.
+  void loadAudioFileAsync(juce::File file, std::function<void(Utils::Result)> onDone);
+  void loadPresetAsync(juce::File file, std::function<void(Utils::Result)> onDone);
+  void cancelLoad();
+  bool isFileLoading() const { return mIsFileLoading.load(); }
+  float getLoadProgress() const { return mLoadProgress.load(); }
+  // 0-1 while the analysis stages run, -1 otherwise
+  float getAnalysisProgress() const { return mAnalysisProgress.load(); }
+  // Message thread, makes the notes, candidates and detected pitches again from the kept transcription with the note
+  // detection settings in ParamUI. Runs on the analysis thread, after the analysis if one is running
+  void updateTranscription();
+  // Bumped every time updateTranscription() made new notes
+  juce::uint32 getTranscriptionVersion() const { return mTranscriptionVersion.load(); }
+  // Message thread, swaps the detected pitches made by the last updateTranscription() into the DETECTED spec. Anything
+  // drawing from it has to be stopped first
+  void publishPitchSpec();
   Utils::Result savePreset(juce::File file);
   Utils::Result savePreset(juce::MemoryBlock& intoBlock);
 
-  void trimAndExtractPitches(juce::Range<double> range);
+  // Decodes and resamples only the range (in seconds) of the input file in the background, onDone is called like the loads
+  // once it replaced the audio buffer and the analysis started
+  void trimAndExtractPitches(juce::Range<double> range, std::function<void(Utils::Result)> onDone);
   std::vector<Utils::SpecBuffer*> getProcessedSpecs() {
     return std::vector<Utils::SpecBuffer*>(mProcessedSpecs.begin(), mProcessedSpecs.end());
   }
@@ -154,6 +197,12 @@ class GranularSynth : public juce::AudioProcessor, public juce::MidiKeyboardStat
   static constexpr int DEFAULT_BEATS_PER_BAR = 4;
   // Param bounds
   static constexpr float MIN_CANDIDATE_SALIENCE = 0.5f;
+  // Compressed streams can't grow by more than this, used to reject sizes a corrupted chunk claims
+  static constexpr size_t MAX_COMPRESSED_EXPANSION = 1032;
+  static constexpr int MAX_PRESET_CHANNELS = 256;  // Far more than any audio file has, more is a corrupted preset
+  // Bump when anything changes the analysis results (or their format) so old cache files are no longer used
+  static constexpr int ANALYSIS_CACHE_VERSION = 7;
+  static constexpr int LOAD_BLOCK_SAMPLES = 1 << 16;  // Decoded at a time so loads can report progress and cancel
   static constexpr int MAX_MIDI_NOTE = 127;
   static constexpr double DEFAULT_SAMPLE_RATE = 48000;  // Sample rate to use before it's officially set in prepareToPlay()
   static constexpr int MAX_PITCH_BEND_SEMITONES = 2;  // Max pitch bend semitones allowed
@@ -163,6 +212,7 @@ class GranularSynth : public juce::AudioProcessor, public juce::MidiKeyboardStat
     Utils::PitchClass pitchClass;
     float velocity;
     int removeTs = -1; // Timestamp when note is released
+    int voice = -1;    // Slot in Parameters::voiceMods, -1 if none was free
     std::array<Utils::EnvelopeADSR, NUM_GENERATORS> genAmpEnvs;
     std::array<juce::Array<Grain*>, NUM_GENERATORS> genGrains;  // Active grains for note per generator
     std::array<float, NUM_GENERATORS> grainTriggers;           // Keeps track of triggering grains from each generator
@@ -186,22 +236,39 @@ class GranularSynth : public juce::AudioProcessor, public juce::MidiKeyboardStat
   Fft mFft;
   HPCP mHPCP;
   BasicPitch mPitchDetector;
-  juce::AudioBuffer<float> mDownsampledAudio; // Used for feeding into pitch detector
   Utils::SpecBuffer mPitchSpecBuffer;
 
   // Bookkeeping
-  juce::AudioBuffer<float> mInputBuffer;  // incoming buffer from file or other source
   juce::AudioBuffer<float> mAudioBuffer;  // final buffer used for actual synth
+  // Backs mAudioBuffer when it's long enough to be streamed from disk, swapped along with it
+  std::unique_ptr<Utils::MappedAudioBuffer> mAudioMapping;
+  // Used instead of mAudioBuffer (left empty then) when Utils::getCompactAudio() is set and it's kept in memory
+  Utils::SampleBuffer mPackedAudio;
+  Utils::SampleBuffer::View mGrainSamples;     // Audio thread, what the grains read this block
   std::array<Utils::SpecBuffer*, ParamUI::SpecType::COUNT> mProcessedSpecs;
   double mSampleRate = DEFAULT_SAMPLE_RATE;
   juce::MidiKeyboardState mKeyboardState;
   juce::AudioFormatManager mFormatManager;
   float mBarsPerSec = (1.0f / DEFAULT_BPM) * 60.0f * DEFAULT_BEATS_PER_BAR;
+  Utils::Transport mTransport;
+  bool mResnapSyncedGrains = false;  // Set when the host tempo or position changed under beat locked grains
   float mCurPitchBendSemitones = 0.0f; // Current pitch bend value from MIDI in semitones
 
   // Reference sine tone
   juce::ToneGeneratorAudioSource mReferenceTone;
 
+  // Reads ahead the trim playback and the pages of a streamed mAudioBuffer
+  juce::TimeSliceThread mReadAheadThread{"read ahead"};
+
+  // Incoming file, kept open (memory mapped when the format allows it) until the trim selection is made. The trim playback
+  // streams from it through the transport, which reads ahead and resamples to the device rate
+  juce::File mInputFile;
+  std::unique_ptr<juce::AudioFormatReader> mInputReader;
+  std::unique_ptr<juce::AudioFormatReaderSource> mInputSource;
+  juce::AudioTransportSource mInputTransport;
+  bool mCanPlayInput = false;       // Under mAudioBufferLock, the audio thread only touches mInputTransport while set
+  int mInputPlaybackSample = -1;    // Audio thread, where the transport is at to notice when the UI moved the playback
+
   // Grain control
   int mTotalSamps;
   juce::OwnedArray<GrainNote, juce::CriticalSection> mActiveNotes;
@@ -218,9 +285,112 @@ class GranularSynth : public juce::AudioProcessor, public juce::MidiKeyboardStat
   // Parameters
   Parameters mParameters;
 
+  // Encoded preset chunks kept between saves, hosts call getStateInformation() often and mostly nothing has changed.
+  // Each is rebuilt when the version of what it was made from no longer matches
+  struct ChunkCache {
+    juce::MemoryBlock data;
+    juce::uint32 version = 0;
+    bool isValid = false;
+
+    bool isCurrent(juce::uint32 newVersion) const { return isValid && version == newVersion; }
+    void setCurrent(juce::uint32 newVersion) {
+      version = newVersion;
+      isValid = true;
+    }
+  };
+  ChunkCache mAudioChunk;
+  ChunkCache mAnalysisChunk;
+  ChunkCache mImagesChunk;
+  ChunkCache mParamsChunk;
+  juce::String mParamsChunkState;  // Notes, UI and modulations part of mParamsChunk
+  // Also held while the audio buffer, note events and candidates are replaced, the state saves read them under it.
+  // Taken before mAudioBufferLock when both are needed
+  juce::CriticalSection mChunkCacheLock;
+  std::atomic<juce::uint32> mAudioVersion{0};  // Bump under mChunkCacheLock whenever mAudioBuffer or mSampleRate changes
+  std::atomic<juce::uint32> mAnalysisVersion{0};  // Bump whenever the transcription or mProcessedSpecs change
+  std::atomic<bool> mIsHostLayoutMissing{false};  // See takeHostLayoutMissing()
+  std::atomic<bool> mHasAnalysis{false};  // The transcription and specs are complete for the current mAudioBuffer
+  // The note detection the pitch detector's note events were made with, negative when not known
+  std::array<float, 3> mNoteDetection = {-1.0f, -1.0f, -1.0f};
+
+  const juce::MemoryBlock& getParamsChunk();
+
+  // A preset read without touching the synth, so it can be done off the message thread. applyPreset() puts it in use
+  struct PresetData {
+    // What data points into when the preset was opened from a file
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    juce::MemoryBlock fileData;
+    const void* data = nullptr;
+    size_t size = 0;
+
+    double sampleRate = 0.0;  // Of audioBuffer, set before reading to the rate to resample to
+    juce::AudioBuffer<float> audioBuffer;
+    std::unique_ptr<Utils::MappedAudioBuffer> audioMapping;
+    // Views into data, null when not in the preset
+    const void* paramsXml = nullptr;
+    int paramsXmlSize = 0;
+    const void* images = nullptr;
+    size_t imagesSize = 0;
+    const void* analysis = nullptr;
+    size_t analysisSize = 0;
+  };
+  Utils::Result openPreset(juce::File file, PresetData& preset);
+  Utils::Result readPreset(const void* data, size_t size, PresetData& preset, const LoadProgress& progress);
+  void applyPreset(PresetData& preset);
+  void setLoadedPresetFile(juce::File file);
+  std::unique_ptr<juce::AudioFormatReader> openAudioFile(juce::File file);
+  // Decodes the range (in samples of the file) to mono and resamples it, mp3s are normalized if the range clips
+  Utils::Result readAudioRange(juce::AudioFormatReader& reader, bool isMp3, juce::Range<juce::int64> range,
+                               juce::AudioBuffer<float>& buffer, std::unique_ptr<Utils::MappedAudioBuffer>& mapping,
+                               double sampleRate, const LoadProgress& progress);
+  // Swap the buffer (and the mapping backing it, if any) in, what they replace is freed once the lock is released
+  void publishAudioBuffer(juce::AudioBuffer<float>& buffer, std::unique_ptr<Utils::MappedAudioBuffer>& mapping,
+                          double sampleRate);
+  void swapAudioBuffer(juce::AudioBuffer<float>& buffer, std::unique_ptr<Utils::MappedAudioBuffer>& mapping);
+  // Where the candidates can make grains read from, kept read ahead when mAudioBuffer is streamed
+  void updateReadAheadHints();
+  void publishInputFile(juce::File file, std::unique_ptr<juce::AudioFormatReader> reader);
+  void closeInputFile();
+  void startLoad(std::function<Utils::Result(const LoadProgress&)> load, std::function<void(Utils::Result)> publish);
+
+  // The audio thread holds it while it reads mAudioBuffer or plays the input file, they are only ever replaced under it
+  juce::SpinLock mAudioBufferLock;
+  juce::ThreadPool mLoadPool{1};
+  std::shared_ptr<std::atomic<bool>> mLoadCancelled;  // Of the latest load, message thread
+  std::atomic<bool> mIsFileLoading{false};
+  std::atomic<float> mLoadProgress{0.0f};
+  juce::SharedResourcePointer<Utils::SharedThreadPool> mWorkerPool;  // Runs the analysis stages
+  std::atomic<float> mAnalysisProgress{-1.0f};
+  // Whether the analysis thread is running (or about to) and what it does, under mTranscriptionLock
+  juce::CriticalSection mTranscriptionLock;
+  bool mIsAnalysisThreadBusy = false;
+  bool mIsTranscriptionOnly = false;  // Skip the analysis, only make the notes again
+  bool mTranscriptionPending = false;  // Note detection changed since the notes were made
+  std::atomic<juce::uint32> mTranscriptionVersion{0};
+  // Detected pitches made while the old ones might be drawn, waiting on publishPitchSpec()
+  juce::CriticalSection mPitchSpecLock;
+  Utils::SpecBuffer mPendingPitchSpec;
+  bool mHasPendingPitchSpec = false;
+  // Preset::AnalysisChunk of the current transcription and specs, false (and nothing written) if there is none yet
+  bool writeAnalysis(juce::OutputStream& out);
+  // Restores what writeAnalysis() saved, on failure nothing is changed
+  bool readAnalysis(const void* data, size_t size);
+  void resetAnalysis();
+  juce::File getAnalysisCacheFile(const juce::AudioBuffer<float>& audioBuffer, bool isFeatureSpecs);
+  // mAudioBuffer, or the packed audio unpacked into scratch
+  juce::AudioBuffer<float>& getFloatAudioBuffer(juce::AudioBuffer<float>& scratch);
+
   void handleNoteOn(juce::MidiKeyboardState* state, int midiChannel, int midiNoteNumber, float velocity) override;
   void handleNoteOff(juce::MidiKeyboardState* state, int midiChannel, int midiNoteNumber, float velocity) override;
   void handleGrainAddRemove(int blockSize);
-  void makePitchSpec();
-  void createCandidates();
+  void analyze();
+  void startAnalysisThread(bool isTranscriptionOnly);  // Message thread, without mTranscriptionLock held
+  void applyTranscriptionParams();  // ParamUI note detection to the pitch detector
+  bool isNoteDetectionCurrent() const;  // The note events were made with the ParamUI note detection
+  void updateNotes();
+  void makePitchSpec(Utils::SpecBuffer& spec);
+  // isKeepingPositions for the same audio, otherwise each generator starts on its own candidate
+  void createCandidates(bool isKeepingPositions = false);
+
+  JUCE_DECLARE_WEAK_REFERENCEABLE(GranularSynth)
 };
@@ -18,53 +18,84 @@ Utils::SpecBuffer* HPCP::process(Utils::SpecBuffer* spec, double sampleRate) {
   if (!spec) return nullptr;
   mHPCP.clear();
   mSampleRate = sampleRate;
-
-  for (size_t frame = 0; frame < spec->size(); ++frame) {
-//    updateProgress(mStartProgress + (mDiffProgress * (static_cast<double>(frame) / static_cast<double>(spec->size()))));
-    mHPCP.emplace_back(std::vector<float>(NUM_HPCP_BINS, 0.0f));
-
-    std::vector<float>& specFrame = (*spec)[frame];
-
-    // Find local peaks to compute HPCP with
-    std::vector<Peak> peaks = getPeaks(MAX_SPEC_PEAKS, specFrame);
-
-    float curMax = 0.0;
-    for (size_t i = 0; i < peaks.size(); ++i) {
-      float peakFreq = ((peaks[i].binNum / (specFrame.size() - 1)) * mSampleRate) / 2;
-      if (peakFreq < MIN_FREQ || peakFreq > MAX_FREQ) continue;
-
-      // Create sum for each pitch class
-      for (int pc = 0; pc < NUM_HPCP_BINS; ++pc) {
-        int pcIdx = (pc + PITCH_CLASS_OFFSET_BINS) % NUM_HPCP_BINS;
-        float centerFreq = REF_FREQ * std::pow(2.0f, pc / (float)NUM_HPCP_BINS);
-
-        // Add contribution from each harmonic
-        for (size_t hIdx = 0; hIdx < mHarmonicWeights.size(); ++hIdx) {
-          float freq = peakFreq * pow(2., -mHarmonicWeights[hIdx].semitone / 12.0);
-          float harmonicWeight = mHarmonicWeights[hIdx].gain;
-          float d = std::fmod(12.0f * std::log2(freq / centerFreq), 12.0f);
-          if (std::abs(d) <= (0.5f * HPCP_WINDOW_LEN)) {
-            float w = std::pow(std::cos((juce::MathConstants<float>::pi * d) / HPCP_WINDOW_LEN), 2.0f);
-            mHPCP[frame][pcIdx] += (w * std::pow(peaks[i].gain, 2) * harmonicWeight * harmonicWeight);
-            if (mHPCP[frame][pcIdx] > curMax) curMax = mHPCP[frame][pcIdx];
-          }
-        }
-      }
+  mHPCP.resize(spec->getNumRows(), NUM_HPCP_BINS);
+
+  const int numFrames = (int)spec->getNumRows();
+  const int numTasks = (numFrames + FRAMES_PER_TASK - 1) / FRAMES_PER_TASK;
+  Utils::parallelFor(mPool->pool, numTasks, [&](int task) {
+    std::vector<Peak> peaks;
+    std::vector<float> octaves((size_t)mNumOctaveBins);
+    for (int frame = task * FRAMES_PER_TASK; frame < juce::jmin(numFrames, (task + 1) * FRAMES_PER_TASK); ++frame) {
+      processFrame((*spec)[(size_t)frame], (int)spec->getNumCols(), mHPCP[(size_t)frame], peaks, octaves);
     }
+  });
+  return &mHPCP;
+}
 
-    // Normalize HPCP frame and clear low energy frames
-    float totalEnergy = 0.0f;
-    if (curMax > 0.0f) {
-      for (int pc = 0; pc < NUM_HPCP_BINS; ++pc) {
-        totalEnergy += mHPCP[frame][pc];
-        mHPCP[frame][pc] /= curMax;
-      }
+void HPCP::processFrame(const float* specFrame, int numBins, float* hpcp, std::vector<Peak>& peaks,
+                        std::vector<float>& octaves) const {
+  // Find local peaks to compute HPCP with
+  getPeaks(MAX_SPEC_PEAKS, specFrame, numBins, peaks);
+
+  // Contributions are added unwrapped, over all the octaves the peaks and their harmonics can be in, then folded
+  std::fill(octaves.begin(), octaves.end(), 0.0f);
+  for (const Peak& peak : peaks) {
+    const float peakFreq = ((peak.binNum / (numBins - 1)) * mSampleRate) / 2;
+    if (peakFreq < MIN_FREQ || peakFreq > MAX_FREQ) continue;
+    const float peakBin = BINS_PER_SEMITONE * 12.0f * std::log2(peakFreq / REF_FREQ);
+    const float peakEnergy = peak.gain * peak.gain;
+
+    // Add contribution from each harmonic, to the bins within the window around it
+    for (const HarmonicWeight& harmonic : mHarmonicWeights) {
+      const float harmonicBin = peakBin - harmonic.semitone * BINS_PER_SEMITONE;
+      const float firstBin = std::floor(harmonicBin);
+      const float* window = mWindowWeights[(size_t)((harmonicBin - firstBin) * WINDOW_STEPS)].data();
+      float* out = octaves.data() + ((int)firstBin - HALF_WINDOW_BINS + mOctaveBinsOffset);
+      const float contribution = peakEnergy * harmonic.gain * harmonic.gain;
+      for (int i = 0; i < WINDOW_BINS; ++i) out[i] += window[i] * contribution;
     }
-    if (totalEnergy / NUM_HPCP_BINS < MIN_AVG_FRAME_ENERGY) {
-      std::fill(mHPCP[frame].begin(), mHPCP[frame].end(), 0.0f);
+  }
+
+  // Fold the octaves into one, starting at the lowest pitch class
+  std::fill_n(hpcp, NUM_HPCP_BINS, 0.0f);
+  for (int bin = 0; bin < mNumOctaveBins; bin += NUM_HPCP_BINS) {
+    juce::FloatVectorOperations::add(hpcp, octaves.data() + bin, NUM_HPCP_BINS);
+  }
+  std::rotate(hpcp, hpcp + NUM_HPCP_BINS - PITCH_CLASS_OFFSET_BINS, hpcp + NUM_HPCP_BINS);
+
+  // Normalize HPCP frame and clear low energy frames
+  const float curMax = juce::FloatVectorOperations::findMaximum(hpcp, NUM_HPCP_BINS);
+  float totalEnergy = 0.0f;
+  if (curMax > 0.0f) {
+    for (int pc = 0; pc < NUM_HPCP_BINS; ++pc) totalEnergy += hpcp[pc];
+    juce::FloatVectorOperations::multiply(hpcp, 1.0f / curMax, NUM_HPCP_BINS);
+  }
+  if (totalEnergy / NUM_HPCP_BINS < MIN_AVG_FRAME_ENERGY) {
+    std::fill_n(hpcp, NUM_HPCP_BINS, 0.0f);
+  }
+}
+
+void HPCP::initWindowWeights() {
+  // cos^2 of the distance in semitones from each bin to a harmonic, for the harmonic at every step between two bins
+  for (int step = 0; step < WINDOW_STEPS; ++step) {
+    const float offset = (float)step / WINDOW_STEPS;
+    for (int i = 0; i < WINDOW_BINS; ++i) {
+      const float d = (offset + HALF_WINDOW_BINS - i) / BINS_PER_SEMITONE;
+      const float w = std::cos((juce::MathConstants<float>::pi * d) / HPCP_WINDOW_LEN);
+      mWindowWeights[(size_t)step][(size_t)i] = (std::abs(d) <= (0.5f * HPCP_WINDOW_LEN)) ? w * w : 0.0f;
     }
   }
-  return &mHPCP;
+
+  // Whole octaves of bins from below the lowest harmonic of MIN_FREQ to above MAX_FREQ, with room for the window, so
+  // octave bin 0 is a multiple of NUM_HPCP_BINS below REF_FREQ
+  float maxSemitone = 0.0f;
+  for (const HarmonicWeight& harmonic : mHarmonicWeights) maxSemitone = juce::jmax(maxSemitone, harmonic.semitone);
+  const float lowestBin = BINS_PER_SEMITONE * (12.0f * std::log2((float)MIN_FREQ / REF_FREQ) - maxSemitone);
+  const float highestBin = BINS_PER_SEMITONE * 12.0f * std::log2((float)MAX_FREQ / REF_FREQ);
+  const int numOctavesBelow = (int)std::ceil((-lowestBin + HALF_WINDOW_BINS + 1) / NUM_HPCP_BINS);
+  const int numOctavesAbove = (int)std::ceil((highestBin + WINDOW_BINS + 1) / NUM_HPCP_BINS);
+  mOctaveBinsOffset = numOctavesBelow * NUM_HPCP_BINS;
+  mNumOctaveBins = (numOctavesBelow + numOctavesAbove) * NUM_HPCP_BINS;
 }
 
 // From essentia:
@@ -102,12 +133,10 @@ void HPCP::initHarmonicWeights() {
   }
 }
 
-std::vector<HPCP::Peak> HPCP::getPeaks(int numPeaks, std::vector<float>& frame) {
-  int size = frame.size();
+void HPCP::getPeaks(int numPeaks, const float* frame, int size, std::vector<Peak>& peaks) const {
   const float scale = 1.0 / (float)(size - 1);
 
-  std::vector<Peak> peaks;
-  peaks.reserve(size);
+  peaks.clear();
 
   // we want to round up to the next integer instead of simple truncation,
   // otherwise the peak frequency at i can be lower than _minPos
@@ -178,8 +207,9 @@ std::vector<HPCP::Peak> HPCP::getPeaks(int numPeaks, std::vector<float>& frame)
 
   // we only want this many peaks
   int nWantedPeaks = juce::jmin(numPeaks, (int)peaks.size());
-  std::sort(peaks.begin(), peaks.end(), [](Peak self, Peak other) { return self.gain > other.gain; });
-  return std::vector<Peak>(peaks.begin(), peaks.begin() + nWantedPeaks);
+  std::partial_sort(peaks.begin(), peaks.begin() + nWantedPeaks, peaks.end(),
+                    [](const Peak& self, const Peak& other) { return self.gain > other.gain; });
+  peaks.resize((size_t)nWantedPeaks);
 }
 
 /**
@@ -16,10 +16,14 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
 #include "Utils/DSP.h"
+#include "Utils/TaskGraph.h"
 
 class HPCP {
  public:
-  HPCP() { initHarmonicWeights(); }
+  HPCP() {
+    initHarmonicWeights();
+    initWindowWeights();
+  }
 
   void clear();
 
@@ -41,6 +45,12 @@ class HPCP {
   static constexpr double MAGNITUDE_THRESHOLD = 0.00001;
   static constexpr int PITCH_CLASS_OFFSET = 9;  // Offset from reference freq A to lowest class C
   static constexpr int PITCH_CLASS_OFFSET_BINS = (NUM_HPCP_BINS / 12) * PITCH_CLASS_OFFSET;
+  static constexpr float BINS_PER_SEMITONE = NUM_HPCP_BINS / 12.0f;
+  // Bins on each side of a harmonic it contributes to, and the ones a precomputed window covers
+  static constexpr int HALF_WINDOW_BINS = (int)(0.5f * HPCP_WINDOW_LEN * BINS_PER_SEMITONE);
+  static constexpr int WINDOW_BINS = 2 * HALF_WINDOW_BINS + 2;
+  static constexpr int WINDOW_STEPS = 256;  // Windows precomputed for a harmonic this many places between two bins
+  static constexpr int FRAMES_PER_TASK = 64;
 
   typedef struct Peak {
     float binNum;  // Bin number in frame
@@ -56,12 +66,20 @@ class HPCP {
   } HarmonicWeight;
 
   void initHarmonicWeights();
-  std::vector<Peak> getPeaks(int numPeaks, std::vector<float>& frame);
+  void initWindowWeights();
+  // peaks and octaves are scratch space, so a thread can reuse them for every frame it processes
+  void processFrame(const float* specFrame, int numBins, float* hpcp, std::vector<Peak>& peaks,
+                    std::vector<float>& octaves) const;
+  void getPeaks(int numPeaks, const float* frame, int size, std::vector<Peak>& peaks) const;
   void interpolatePeak(const float leftVal, const float middleVal, const float rightVal, int currentBin, float& resultVal,
                        float& resultBin) const;
 
   // HPCP fields
   double mSampleRate;
   std::vector<HarmonicWeight> mHarmonicWeights;
+  std::array<std::array<float, WINDOW_BINS>, WINDOW_STEPS> mWindowWeights;
+  int mOctaveBinsOffset = 0;  // Where REF_FREQ is in the unfolded bins
+  int mNumOctaveBins = 0;
+  juce::SharedResourcePointer<Utils::SharedThreadPool> mPool;
   Utils::SpecBuffer mHPCP;  // harmonic pitch class profile
 };
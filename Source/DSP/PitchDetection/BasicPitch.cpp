@@ -4,13 +4,22 @@
 
 #include "BasicPitch.h"
 
+#include <random>
+
+BasicPitch::BasicPitch()
+{
+    mCNNs.push_back(std::make_unique<BasicPitchCNN>());
+}
+
 void BasicPitch::reset()
 {
-    mBasicPitchCNN.reset();
+    mCNNs[0]->reset();
     mContoursPG.clear();
     mNotesPG.clear();
     mOnsetsPG.clear();
     mNoteEvents.clear();
+    mFeatureSpectrogram.clear();
+    mFeatureChroma.clear();
 
     mNumFrames = 0;
 }
@@ -20,11 +29,9 @@ void BasicPitch::setParameters(float inNoteSensibility, float inSplitSensibility
     mParams.frameThreshold = 1.0f - inNoteSensibility;
     mParams.onsetThreshold = 1.0f - inSplitSensibility;
 
-    mParams.minNoteLength = static_cast<int>(std::round(inMinNoteDurationMs * FFT_HOP / BASIC_PITCH_SAMPLE_RATE));
-
-    mParams.pitchBend = MultiPitchBend;
-    mParams.melodiaTrick = true;
-    mParams.inferOnsets = true;
+    // One frame every FFT_HOP samples
+    mParams.minNoteLength =
+        static_cast<int>(std::round(inMinNoteDurationMs / 1000.0 * BASIC_PITCH_SAMPLE_RATE / FFT_HOP));
 }
 
 void BasicPitch::transcribeToMIDI(float* inAudio, int inNumSamples)
@@ -49,46 +56,224 @@ void BasicPitch::transcribeToMIDI(float* inAudio, int inNumSamples)
     }
 #endif
 
-    const float* stacked_cqt = mFeaturesCalculator.computeFeatures(inAudio, inNumSamples, mNumFrames);
+    beginTranscription();
+    pushAudio(inAudio, static_cast<size_t>(inNumSamples));
+    endTranscription();
+}
+
+void BasicPitch::beginTranscription()
+{
+    reset();
 
-    mOnsetsPG.resize(mNumFrames, std::vector<float>(NUM_FREQ_OUT, 0.0f));
-    mNotesPG.resize(mNumFrames, std::vector<float>(NUM_FREQ_OUT, 0.0f));
-    mContoursPG.resize(mNumFrames, std::vector<float>(NUM_FREQ_IN, 0.0f));
+    mPendingAudio.clear();
+    mPendingStart = 0;
+    mNextWindowFrame = 0;
+    mNumSteps = 0;
 
-    mBasicPitchCNN.reset();
+    mZeroFeatures.assign(NUM_HARMONICS * NUM_FREQ_IN, 0.0f);
 
-    const size_t num_lh_frames = BasicPitchCNN::getNumFramesLookahead();
+    // One CNN per thread that can run a segment, they are expensive to make so they are kept for the next transcriptions
+    const size_t num_cnns = std::min(MAX_SEGMENTS, static_cast<size_t>(mPool->pool.getNumThreads()) + 1);
+    while (mCNNs.size() < num_cnns) {
+        mCNNs.push_back(std::make_unique<BasicPitchCNN>());
+    }
 
-    std::vector<float> zero_stacked_cqt(NUM_HARMONICS * NUM_FREQ_IN, 0.0f);
+#ifndef NDEBUG
+    // Once, a segment too short on warm-up would only differ by a little in its first frames
+    static const bool is_segmenting_exact = _isSegmentingExact();
+    assert(is_segmenting_exact);
+#endif
 
     // Run the CNN with 0 input and discard output (only for num_lh_frames)
-    for (int i = 0; i < num_lh_frames; i++) {
-        mBasicPitchCNN.frameInference(zero_stacked_cqt.data(), mContoursPG[0], mNotesPG[0], mOnsetsPG[0]);
-    }
+    _runFrames(std::vector<const float*>(BasicPitchCNN::getNumFramesLookahead(), nullptr));
+}
 
-    // Run the CNN with real inputs and discard outputs (only for num_lh_frames)
-    for (size_t frame_idx = 0; frame_idx < num_lh_frames; frame_idx++) {
-        mBasicPitchCNN.frameInference(
-            stacked_cqt + frame_idx * NUM_HARMONICS * NUM_FREQ_IN, mContoursPG[0], mNotesPG[0], mOnsetsPG[0]);
+void BasicPitch::pushAudio(const float* inAudio, size_t inNumSamples)
+{
+    mPendingAudio.insert(mPendingAudio.end(), inAudio, inAudio + inNumSamples);
+
+    // A window can run once the audio of its right margin is there too
+    while (mPendingStart + mPendingAudio.size() >= (mNextWindowFrame + WINDOW_FRAMES + FEATURES_MARGIN_FRAMES) * FFT_HOP) {
+        _processWindow(false);
     }
+}
 
-    // Run the CNN with real inputs and correct outputs
-    for (size_t frame_idx = num_lh_frames; frame_idx < mNumFrames; frame_idx++) {
-        mBasicPitchCNN.frameInference(stacked_cqt + frame_idx * NUM_HARMONICS * NUM_FREQ_IN,
-                                      mContoursPG[frame_idx - num_lh_frames],
-                                      mNotesPG[frame_idx - num_lh_frames],
-                                      mOnsetsPG[frame_idx - num_lh_frames]);
+void BasicPitch::endTranscription()
+{
+    if (mPendingStart + mPendingAudio.size() > 0) {
+        _processWindow(true);
     }
 
+    mPendingAudio.clear();
+    mPendingAudio.shrink_to_fit();
+
     // Run end with zeroes as input and last frames as output
-    for (size_t frame_idx = mNumFrames; frame_idx < mNumFrames + num_lh_frames; frame_idx++) {
-        mBasicPitchCNN.frameInference(zero_stacked_cqt.data(),
-                                      mContoursPG[frame_idx - num_lh_frames],
-                                      mNotesPG[frame_idx - num_lh_frames],
-                                      mOnsetsPG[frame_idx - num_lh_frames]);
-    }
+    _runFrames(std::vector<const float*>(BasicPitchCNN::getNumFramesLookahead(), nullptr));
 
+    mNumFrames = mNotesPG.getNumRows();
     mNoteEvents = mNotesCreator.convert(mNotesPG, mOnsetsPG, mContoursPG, mParams);
+
+    // Same scale for every row, like the HPCP frames
+    for (size_t row = 0; row < mFeatureChroma.getNumRows(); row++) {
+        float* chroma = mFeatureChroma[row];
+        const float max_value = *std::max_element(chroma, chroma + CHROMA_BINS);
+        if (max_value > 0.0f) {
+            for (int bin = 0; bin < CHROMA_BINS; bin++) {
+                chroma[bin] /= max_value;
+            }
+        }
+    }
+}
+
+void BasicPitch::takeFeatureSpecs(Utils::Matrix<float>& outSpectrogram, Utils::Matrix<float>& outChroma)
+{
+    outSpectrogram = std::move(mFeatureSpectrogram);
+    outChroma = std::move(mFeatureChroma);
+}
+
+void BasicPitch::_addFeatureSpecs(const float* inStackedCQT, size_t inFrame)
+{
+    const size_t row = inFrame / FEATURE_SPEC_FRAMES;
+    if (row >= mFeatureSpectrogram.getNumRows()) {
+        mFeatureSpectrogram.resize(row + 1, NUM_FREQ_IN);
+        mFeatureChroma.resize(row + 1, CHROMA_BINS);
+    }
+
+    float* spectrogram = mFeatureSpectrogram[row];
+    float* chroma = mFeatureChroma[row];
+    for (int bin = 0; bin < NUM_FREQ_IN; bin++) {
+        const float value = inStackedCQT[bin * NUM_HARMONICS + CQT_HARMONIC_IDX];
+        spectrogram[bin] += value / FEATURE_SPEC_FRAMES;
+        chroma[(bin + CHROMA_OFFSET_BINS) % CHROMA_BINS] += value * value;
+    }
+}
+
+void BasicPitch::_processWindow(bool inIsLast)
+{
+    const size_t core_start = mNextWindowFrame * FFT_HOP;
+    const size_t input_start = core_start - std::min(core_start, FEATURES_MARGIN_FRAMES * FFT_HOP);
+    const size_t pending_end = mPendingStart + mPendingAudio.size();
+    const size_t input_end =
+        inIsLast ? pending_end : std::min(pending_end, core_start + (WINDOW_FRAMES + FEATURES_MARGIN_FRAMES) * FFT_HOP);
+    assert(input_start >= mPendingStart && input_end > input_start);
+
+    size_t num_frames = 0;
+    const float* stacked_cqt = mFeaturesCalculator.computeFeatures(
+        mPendingAudio.data() + (input_start - mPendingStart), input_end - input_start, num_frames);
+
+    // input_start is a multiple of the hop, so frames of the window line up with the frames of the whole input
+    const size_t first_frame = (core_start - input_start) / FFT_HOP;
+    const size_t end_frame = inIsLast ? num_frames : std::min(num_frames, first_frame + WINDOW_FRAMES);
+    std::vector<const float*> frames;
+    for (size_t frame_idx = first_frame; frame_idx < end_frame; frame_idx++) {
+        frames.push_back(stacked_cqt + frame_idx * NUM_HARMONICS * NUM_FREQ_IN);
+        if (mMakeFeatureSpecs) {
+            _addFeatureSpecs(frames.back(), mNextWindowFrame + frame_idx - first_frame);
+        }
+    }
+    _runFrames(frames);
+    mNextWindowFrame += end_frame - std::min(end_frame, first_frame);
+
+    // Drop the audio before the left margin of the next window
+    const size_t next_core_start = mNextWindowFrame * FFT_HOP;
+    const size_t next_input_start = next_core_start - std::min(next_core_start, FEATURES_MARGIN_FRAMES * FFT_HOP);
+    const size_t num_drop = std::min(mPendingAudio.size(), next_input_start - std::min(next_input_start, mPendingStart));
+    mPendingAudio.erase(mPendingAudio.begin(), mPendingAudio.begin() + static_cast<std::ptrdiff_t>(num_drop));
+    mPendingStart += num_drop;
+}
+
+void BasicPitch::_runFrames(const std::vector<const float*>& inFrames)
+{
+    const size_t num_frames = inFrames.size();
+    // Outputs of the leading zeros and of the real frames filling the lookahead come before the first frame
+    const size_t num_skipped = 2 * static_cast<size_t>(BasicPitchCNN::getNumFramesLookahead());
+    const size_t end_step = mNumSteps + num_frames;
+    if (end_step > num_skipped) {
+        mContoursPG.resize(end_step - num_skipped, NUM_FREQ_IN);
+        mNotesPG.resize(end_step - num_skipped, NUM_FREQ_OUT);
+        mOnsetsPG.resize(end_step - num_skipped, NUM_FREQ_OUT);
+    }
+
+    const size_t num_warmup = static_cast<size_t>(BasicPitchCNN::getNumFramesWarmup());
+    const size_t num_segments = std::max(size_t(1), std::min(num_frames / MIN_SEGMENT_FRAMES, mCNNs.size()));
+
+    Utils::parallelFor(mPool->pool, static_cast<int>(num_segments), [&](int segment) {
+        const size_t start = num_frames * segment / num_segments;
+        const size_t end = num_frames * (segment + 1) / num_segments;
+        BasicPitchCNN& cnn = *mCNNs[segment];
+        const auto frame = [&](size_t i) { return inFrames[i] != nullptr ? inFrames[i] : mZeroFeatures.data(); };
+
+        std::array<float, NUM_FREQ_IN> discard_contours;
+        std::array<float, NUM_FREQ_OUT> discard_notes;
+        std::array<float, NUM_FREQ_OUT> discard_onsets;
+
+        // The first segment carries on from the state of the previous frames. The others start from a reset CNN and
+        // get the frames before them first (outputs discarded), which leaves the CNN in the exact same state.
+        if (segment > 0) {
+            assert(start >= num_warmup);
+            cnn.reset();
+            for (size_t i = start - num_warmup; i < start; i++) {
+                cnn.frameInference(frame(i), discard_contours.data(), discard_notes.data(), discard_onsets.data());
+            }
+        }
+
+        for (size_t i = start; i < end; i++) {
+            const size_t step = mNumSteps + i;
+            if (step < num_skipped) {
+                cnn.frameInference(frame(i), discard_contours.data(), discard_notes.data(), discard_onsets.data());
+            } else {
+                cnn.frameInference(frame(i),
+                                   mContoursPG[step - num_skipped],
+                                   mNotesPG[step - num_skipped],
+                                   mOnsetsPG[step - num_skipped]);
+            }
+        }
+    });
+
+    // The CNN of the last segment is where the next frames carry on from
+    std::swap(mCNNs[0], mCNNs[num_segments - 1]);
+    mNumSteps = end_step;
+}
+
+bool BasicPitch::_isSegmentingExact()
+{
+    // The segment starts well past the warm-up, so the serial CNN has frames before it the segment never gets
+    const size_t num_warmup = static_cast<size_t>(BasicPitchCNN::getNumFramesWarmup());
+    const size_t start = 3 * num_warmup;
+    const size_t num_frames = start + 2 * num_warmup;
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<float> features(num_frames * NUM_HARMONICS * NUM_FREQ_IN);
+    for (float& value: features) {
+        value = distribution(generator);
+    }
+    const auto frame = [&](size_t i) { return features.data() + i * NUM_HARMONICS * NUM_FREQ_IN; };
+
+    BasicPitchCNN serial;
+    BasicPitchCNN segmented;
+    serial.reset();
+    segmented.reset();
+
+    std::array<float, NUM_FREQ_IN> serial_contours, segmented_contours;
+    std::array<float, NUM_FREQ_OUT> serial_notes, segmented_notes;
+    std::array<float, NUM_FREQ_OUT> serial_onsets, segmented_onsets;
+    for (size_t i = 0; i < start; i++) {
+        serial.frameInference(frame(i), serial_contours.data(), serial_notes.data(), serial_onsets.data());
+    }
+    for (size_t i = start - num_warmup; i < start; i++) {
+        segmented.frameInference(frame(i), segmented_contours.data(), segmented_notes.data(), segmented_onsets.data());
+    }
+
+    for (size_t i = start; i < num_frames; i++) {
+        serial.frameInference(frame(i), serial_contours.data(), serial_notes.data(), serial_onsets.data());
+        segmented.frameInference(frame(i), segmented_contours.data(), segmented_notes.data(), segmented_onsets.data());
+        if (serial_contours != segmented_contours || serial_notes != segmented_notes
+            || serial_onsets != segmented_onsets) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void BasicPitch::updateMIDI()
@@ -100,3 +285,19 @@ const std::vector<Notes::Event>& BasicPitch::getNoteEvents() const
 {
     return mNoteEvents;
 }
+
+void BasicPitch::setTranscription(Utils::Matrix<float>&& inContoursPG,
+                                  Utils::Matrix<float>&& inNotesPG,
+                                  Utils::Matrix<float>&& inOnsetsPG,
+                                  std::vector<Notes::Event>&& inNoteEvents)
+{
+    assert(inNotesPG.getNumRows() == inContoursPG.getNumRows());
+    assert(inOnsetsPG.getNumRows() == inContoursPG.getNumRows());
+
+    mContoursPG = std::move(inContoursPG);
+    mNotesPG = std::move(inNotesPG);
+    mOnsetsPG = std::move(inOnsetsPG);
+    mNoteEvents = std::move(inNoteEvents);
+
+    mNumFrames = mContoursPG.getNumRows();
+}
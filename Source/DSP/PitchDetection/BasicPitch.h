@@ -10,13 +10,16 @@
 #include "Features.h"
 #include "Notes.h"
 
+#include <memory>
+#include "Utils/TaskGraph.h"
+
 /**
  * Class to get midi transcription from raw audio.
  */
 class BasicPitch
 {
 public:
-    BasicPitch() = default;
+    BasicPitch();
 
     /**
      * Resets all states of model, clear the posteriorgrams vector computed by the CNN and the note event vector.
@@ -24,7 +27,7 @@ public:
     void reset();
 
     /**
-     * Set parameters for next transcription or midi update.
+     * Set parameters for next transcription or midi update. The other conversion settings are left as they are.
      * @param inNoteSensibility Note sensibility threshold (0.05, 0.95). Higher gives more notes.
      * @param inSplitSensibility Split sensibility threshold (0.05, 0.95). Higher will split note more, lower will merge close notes with same pitch
      * @param inMinNoteDurationMs Minimum note duration to keep in ms.
@@ -38,6 +41,41 @@ public:
      */
     void transcribeToMIDI(float* inAudio, int inNumSamples);
 
+    /**
+     * Streaming version of transcribeToMIDI: beginTranscription, then pushAudio as the audio becomes available (blocks of
+     * any size), then endTranscription. Features and CNN run a window at a time as soon as enough audio was pushed, so
+     * only about a window of audio and features is kept around however long the input is.
+     */
+    void beginTranscription();
+
+    /**
+     * @param inAudio Pointer to raw audio (must be at 22050 Hz), following what was pushed before
+     * @param inNumSamples Number of input samples available.
+     */
+    void pushAudio(const float* inAudio, size_t inNumSamples);
+
+    /**
+     * Runs the last window and creates the note events, same result as transcribeToMIDI with all the audio pushed.
+     */
+    void endTranscription();
+
+    /**
+     * Also make views of the input from the CQT the features are stacked from while transcribing: a log frequency
+     * spectrogram and a chroma, one row per FEATURE_SPEC_FRAMES frames. Spares a separate spectral analysis of the input.
+     * Applies from the next beginTranscription.
+     */
+    void setMakeFeatureSpecs(bool inMake) { mMakeFeatureSpecs = inMake; }
+
+    /**
+     * Moves out the views made by the last transcription, they are empty if setMakeFeatureSpecs was off.
+     * @param outSpectrogram NUM_FREQ_IN log spaced bins per row, from ANNOTATIONS_BASE_FREQUENCY up
+     * @param outChroma CHROMA_BINS bins per row starting at C, normalized to 0-1 per row
+     */
+    void takeFeatureSpecs(Utils::Matrix<float>& outSpectrogram, Utils::Matrix<float>& outChroma);
+
+    static constexpr size_t FEATURE_SPEC_FRAMES = 8;
+    static constexpr int CHROMA_BINS = 12 * CONTOURS_BINS_PER_SEMITONE;
+
     /**
      * Retrieve the number of frames used in the transcription
      */
@@ -54,20 +92,98 @@ public:
      */
     const std::vector<Notes::Event>& getNoteEvents() const;
 
+    /**
+     * Posteriorgrams of the last transcription, one row per frame.
+     */
+    const Utils::Matrix<float>& getContoursPG() const { return mContoursPG; }
+    const Utils::Matrix<float>& getNotesPG() const { return mNotesPG; }
+    const Utils::Matrix<float>& getOnsetsPG() const { return mOnsetsPG; }
+
+    /**
+     * Restore a previous transcription (ie from a preset) without running Features + CNN.
+     * updateMIDI can be called after it as if transcribeToMIDI had been run.
+     * @param inContoursPG Contour posteriorgrams, the number of frames is taken from it
+     * @param inNotesPG Note posteriorgrams
+     * @param inOnsetsPG Onset posteriorgrams
+     * @param inNoteEvents Note events of the transcription
+     */
+    void setTranscription(Utils::Matrix<float>&& inContoursPG,
+                          Utils::Matrix<float>&& inNotesPG,
+                          Utils::Matrix<float>&& inOnsetsPG,
+                          std::vector<Notes::Event>&& inNoteEvents);
+
 private:
-    // Posteriorgrams vector
-    std::vector<std::vector<float>> mContoursPG;
-    std::vector<std::vector<float>> mNotesPG;
-    std::vector<std::vector<float>> mOnsetsPG;
+    // Frames of features computed per window. The audio given to Features also has FEATURES_MARGIN_FRAMES either side
+    // of the window (as far as there is audio), which covers the longest CQT kernel so no frame kept is cut short.
+    // The features model normalizes the log CQT over the audio of each call though, so each window is scaled by its own
+    // range: audio longer than a window isn't transcribed exactly as in one pass over all of it, quiet windows next to
+    // loud ones come out relatively louder.
+    static constexpr size_t WINDOW_FRAMES = 2048;
+    static constexpr size_t FEATURES_MARGIN_FRAMES = 128;
+
+    /**
+     * Computes features of the next window and runs the CNN on its frames.
+     * @param inIsLast Last window, it goes up to the end of the pushed audio instead of WINDOW_FRAMES.
+     */
+    void _processWindow(bool inIsLast);
+
+    /**
+     * Runs the CNN on the next frames, the outputs (lagging by the CNN lookahead) are written to the posteriorgrams.
+     * Frames are split in segments that run in parallel, each on its own CNN.
+     * @param inFrames Features of each frame, nullptr for zeros (the lookahead padding at the start and the end).
+     */
+    void _runFrames(const std::vector<const float*>& inFrames);
+
+    /**
+     * Runs random frames on a CNN from the start and on another one from a reset after the warm-up, like a segment.
+     * Only used in debug builds, to check BasicPitchCNN::getNumFramesWarmup().
+     * @return The outputs of both are the same
+     */
+    static bool _isSegmentingExact();
+
+    /**
+     * Adds a frame of features to the feature specs.
+     * @param inStackedCQT Features of the frame
+     * @param inFrame Frame number in the whole input
+     */
+    void _addFeatureSpecs(const float* inStackedCQT, size_t inFrame);
+
+    // Harmonic of the stack that is the CQT itself, the stack is (0.5, 1, 2, ..., NUM_HARMONICS - 1)
+    static constexpr int CQT_HARMONIC_IDX = 1;
+    // The CQT starts at A, C is 9 semitones under it
+    static constexpr int CHROMA_OFFSET_BINS = 9 * CONTOURS_BINS_PER_SEMITONE;
+
+    // Segments are at least this long, so the warm-up each one needs stays a small part of the work
+    static constexpr size_t MIN_SEGMENT_FRAMES = 256;
+    static constexpr size_t MAX_SEGMENTS = 16;
+
+    // Pushed audio not needed by a window yet, starting at sample mPendingStart of the input
+    std::vector<float> mPendingAudio;
+    size_t mPendingStart = 0;
+    size_t mNextWindowFrame = 0;
+    // Frames given to the CNN, including the leading zeros
+    size_t mNumSteps = 0;
+    std::vector<float> mZeroFeatures;
+
+    // Posteriorgrams, written by the CNN straight into their rows
+    Utils::Matrix<float> mContoursPG;
+    Utils::Matrix<float> mNotesPG;
+    Utils::Matrix<float> mOnsetsPG;
 
     std::vector<Notes::Event> mNoteEvents;
 
+    bool mMakeFeatureSpecs = false;
+    Utils::Matrix<float> mFeatureSpectrogram;
+    Utils::Matrix<float> mFeatureChroma;
+
     Notes::ConvertParams mParams;
 
     size_t mNumFrames = 0;
 
     Features mFeaturesCalculator;
-    BasicPitchCNN mBasicPitchCNN;
+    // [0] holds the state the next frames carry on from, the others are for the parallel segments
+    std::vector<std::unique_ptr<BasicPitchCNN>> mCNNs;
+    juce::SharedResourcePointer<Utils::SharedThreadPool> mPool;
     Notes mNotesCreator;
 };
 
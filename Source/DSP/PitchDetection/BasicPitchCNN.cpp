@@ -62,31 +62,30 @@ int BasicPitchCNN::getNumFramesLookahead()
     return mTotalLookahead;
 }
 
-void BasicPitchCNN::frameInference(const float* inData,
-                                   std::vector<float>& outContours,
-                                   std::vector<float>& outNotes,
-                                   std::vector<float>& outOnsets)
+int BasicPitchCNN::getNumFramesWarmup()
 {
-    // Checks on parameters
-    assert(outContours.size() == NUM_FREQ_IN);
-    assert(outNotes.size() == NUM_FREQ_OUT);
-    assert(outOnsets.size() == NUM_FREQ_OUT);
+    // The onset output reaches 20 frames back, through the contour (2 + 4), note (6 + 6) and onset output (2) convs
+    static_assert(mNumFramesWarmup == 20);
+    return mNumFramesWarmup;
+}
 
+void BasicPitchCNN::frameInference(const float* inData, float* outContours, float* outNotes, float* outOnsets)
+{
     // Copy data in aligned input array for inference
     std::copy(inData, inData + NUM_HARMONICS * NUM_FREQ_IN, mInputArray.begin());
 
     _runModels();
 
     // Fill output vectors
-    std::copy(mCNNOnsetOutput.getOutputs(), mCNNOnsetOutput.getOutputs() + NUM_FREQ_OUT, outOnsets.begin());
+    std::copy(mCNNOnsetOutput.getOutputs(), mCNNOnsetOutput.getOutputs() + NUM_FREQ_OUT, outOnsets);
 
     std::copy(mNotesCircularBuffer[(size_t) _wrapIndex(mNoteIdx + 1, mNumNoteStored)].begin(),
               mNotesCircularBuffer[(size_t) _wrapIndex(mNoteIdx + 1, mNumNoteStored)].end(),
-              outNotes.begin());
+              outNotes);
 
     std::copy(mContoursCircularBuffer[(size_t) _wrapIndex(mContourIdx + 1, mNumContourStored)].begin(),
               mContoursCircularBuffer[(size_t) _wrapIndex(mContourIdx + 1, mNumContourStored)].end(),
-              outContours.begin());
+              outContours);
 
     // Increment index for different circular buffers
     mContourIdx = (mContourIdx == mNumContourStored - 1) ? 0 : mContourIdx + 1;
@@ -5,6 +5,8 @@
 #ifndef BasicPitchCNN_h
 #define BasicPitchCNN_h
 
+#include <algorithm>
+
 #include "RTNeural/RTNeural.h"
 
 #include "BinaryData.h"
@@ -32,17 +34,20 @@ public:
      */
     static int getNumFramesLookahead();
 
+    /**
+     * @return How many frames back the outputs can depend on. After a reset, running this many frames leaves the CNN in
+     * the same state as if it had run from the start, so frame ranges can run on separate instances.
+     */
+    static int getNumFramesWarmup();
+
     /**
      * Run inference for a single frame. inData should have 8 * 264 elements
      * @param inData input features (CQT harmonically stacked).
-     * @param outContours output vector for contour posteriorgrams. Size should be 264
-     * @param outNotes output vector for note posteriorgrams. Size should be 88
-     * @param outOnsets output vector for onset posteriorgrams. Size should be 88
+     * @param outContours output for contour posteriorgrams (ie a matrix row). Size should be 264
+     * @param outNotes output for note posteriorgrams. Size should be 88
+     * @param outOnsets output for onset posteriorgrams. Size should be 88
      */
-    void frameInference(const float* inData,
-                        std::vector<float>& outContours,
-                        std::vector<float>& outNotes,
-                        std::vector<float>& outOnsets);
+    void frameInference(const float* inData, float* outContours, float* outNotes, float* outOnsets);
 
 private:
     /**
@@ -77,6 +82,24 @@ private:
     static constexpr int mNumNoteStored = mTotalLookahead - (mLookaheadCNNContour + mLookaheadCNNNote) + 1;
     static constexpr int mNumConcat2Stored = mLookaheadCNNContour + mLookaheadCNNNote - mLookaheadCNNOnsetInput + 1;
 
+    // Time kernel size of each conv layer, each one keeps that many frames minus one of its input
+    static constexpr int mTimeKernelContour1 = 3;
+    static constexpr int mTimeKernelContour2 = 5;
+    static constexpr int mTimeKernelNote1 = 7;
+    static constexpr int mTimeKernelNote2 = 7;
+    static constexpr int mTimeKernelOnsetInput = 5;
+    static constexpr int mTimeKernelOnsetOutput = 3;
+
+    // How many frames back each output and stored frame depends on, the circular buffers add their delays to it
+    static constexpr int mDepthContour = (mTimeKernelContour1 - 1) + (mTimeKernelContour2 - 1);
+    static constexpr int mDepthNote = mDepthContour + (mTimeKernelNote1 - 1) + (mTimeKernelNote2 - 1);
+    static constexpr int mDepthConcat2 = (mTimeKernelOnsetInput - 1) + (mNumConcat2Stored - 1);
+    static constexpr int mDepthOnset = std::max(mDepthNote, mDepthConcat2) + (mTimeKernelOnsetOutput - 1);
+    static constexpr int mNumFramesWarmup = std::max({mDepthOnset,
+                                                      mDepthContour + mNumContourStored - 1,
+                                                      mDepthNote + mNumNoteStored - 1,
+                                                      mDepthConcat2});
+
     std::array<std::array<float, NUM_FREQ_IN>, mNumContourStored> mContoursCircularBuffer {};
     std::array<std::array<float, NUM_FREQ_OUT>, mNumNoteStored> mNotesCircularBuffer {}; // Also concat 1
     std::array<std::array<float, 32 * NUM_FREQ_OUT>, mNumConcat2Stored> mConcat2CircularBuffer {};
@@ -88,32 +111,32 @@ private:
     RTNeural::ModelT<float,
                      NUM_FREQ_IN * NUM_HARMONICS,
                      NUM_FREQ_IN,
-                     RTNeural::Conv2DT<float, NUM_HARMONICS, 8, NUM_FREQ_IN, 3, 39, 1, 1, false>,
+                     RTNeural::Conv2DT<float, NUM_HARMONICS, 8, NUM_FREQ_IN, mTimeKernelContour1, 39, 1, 1, false>,
                      RTNeural::ReLuActivationT<float, 8 * NUM_FREQ_IN>,
-                     RTNeural::Conv2DT<float, 8, 1, NUM_FREQ_IN, 5, 5, 1, 1, false>,
+                     RTNeural::Conv2DT<float, 8, 1, NUM_FREQ_IN, mTimeKernelContour2, 5, 1, 1, false>,
                      RTNeural::SigmoidActivationT<float, NUM_FREQ_IN>>
         mCNNContour;
 
     RTNeural::ModelT<float,
                      NUM_FREQ_IN,
                      NUM_FREQ_OUT,
-                     RTNeural::Conv2DT<float, 1, 32, NUM_FREQ_IN, 7, 7, 1, 3, false>,
+                     RTNeural::Conv2DT<float, 1, 32, NUM_FREQ_IN, mTimeKernelNote1, 7, 1, 3, false>,
                      RTNeural::ReLuActivationT<float, 32 * NUM_FREQ_OUT>,
-                     RTNeural::Conv2DT<float, 32, 1, NUM_FREQ_OUT, 7, 3, 1, 1, false>,
+                     RTNeural::Conv2DT<float, 32, 1, NUM_FREQ_OUT, mTimeKernelNote2, 3, 1, 1, false>,
                      RTNeural::SigmoidActivationT<float, NUM_FREQ_OUT>>
         mCNNNote;
 
     RTNeural::ModelT<float,
                      NUM_FREQ_IN * NUM_HARMONICS,
                      32 * NUM_FREQ_OUT,
-                     RTNeural::Conv2DT<float, 8, 32, NUM_FREQ_IN, 5, 5, 1, 3, false>,
+                     RTNeural::Conv2DT<float, 8, 32, NUM_FREQ_IN, mTimeKernelOnsetInput, 5, 1, 3, false>,
                      RTNeural::ReLuActivationT<float, 32 * NUM_FREQ_OUT>>
         mCNNOnsetInput;
 
     RTNeural::ModelT<float,
                      33 * NUM_FREQ_OUT,
                      NUM_FREQ_OUT,
-                     RTNeural::Conv2DT<float, 33, 1, NUM_FREQ_OUT, 3, 3, 1, 1, false>,
+                     RTNeural::Conv2DT<float, 33, 1, NUM_FREQ_OUT, mTimeKernelOnsetOutput, 3, 1, 1, false>,
                      RTNeural::SigmoidActivationT<float, NUM_FREQ_OUT>>
         mCNNOnsetOutput;
 };
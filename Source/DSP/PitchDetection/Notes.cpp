@@ -21,25 +21,25 @@ bool Notes::Event::operator==(const Notes::Event& other) const
            && this->bends == other.bends;
 }
 
-std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>& inNotesPG,
-                                         const std::vector<std::vector<float>>& inOnsetsPG,
-                                         const std::vector<std::vector<float>>& inContoursPG,
+std::vector<Notes::Event> Notes::convert(const Utils::Matrix<float>& inNotesPG,
+                                         const Utils::Matrix<float>& inOnsetsPG,
+                                         const Utils::Matrix<float>& inContoursPG,
                                          ConvertParams inParams)
 {
     std::vector<Notes::Event> events;
     events.reserve(1000);
 
-    auto n_frames = inNotesPG.size();
+    auto n_frames = inNotesPG.getNumRows();
     if (n_frames == 0) {
         return events;
     }
 
-    auto n_notes = inNotesPG[0].size();
-    assert(n_frames == inOnsetsPG.size());
-    assert(n_frames == inContoursPG.size());
-    assert(n_notes == inOnsetsPG[0].size());
+    auto n_notes = inNotesPG.getNumCols();
+    assert(n_frames == inOnsetsPG.getNumRows());
+    assert(n_frames == inContoursPG.getNumRows());
+    assert(n_notes == inOnsetsPG.getNumCols());
 
-    std::vector<std::vector<float>> inferred_onsets;
+    Utils::Matrix<float> inferred_onsets;
     auto onsets_ptr = &inOnsetsPG;
     if (inParams.inferOnsets) {
         inferred_onsets = _inferredOnsets<float>(inOnsetsPG, inNotesPG);
@@ -47,14 +47,21 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
     }
     auto& onsets = *onsets_ptr;
 
-    // deep copy
-    auto remaining_energy = inNotesPG;
-
-    // to-be-sorted index of remaining_energy
-    std::vector<_pg_index> remaining_energy_index;
-    if (inParams.melodiaTrick) {
-        remaining_energy_index.reserve(n_frames * n_notes);
-    }
+    // Remaining energy is the note posteriorgram with cells zeroed as notes take them. Only which cells are zeroed is
+    // kept, instead of a copy of the whole posteriorgram
+    Utils::Matrix<uint8_t> energy_used(n_frames, n_notes);
+    const auto remaining_energy = [&](int frame_idx, int note_idx) {
+        return energy_used[frame_idx][note_idx] ? 0.0f : inNotesPG[frame_idx][note_idx];
+    };
+    const auto zero_energy = [&](int frame_idx, int note_idx) {
+        energy_used[frame_idx][note_idx] = 1;
+        if (note_idx < MAX_NOTE_IDX) {
+            energy_used[frame_idx][note_idx + 1] = 1;
+        }
+        if (note_idx > 0) {
+            energy_used[frame_idx][note_idx - 1] = 1;
+        }
+    };
 
     auto frame_threshold = inParams.frameThreshold;
     // TODO: infer frame_threshold if < 0, can be merged with inferredOnsets.
@@ -73,11 +80,6 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
         for (int note_idx = max_note_idx; note_idx >= min_note_idx; note_idx--) {
             auto onset = onsets[frame_idx][note_idx];
 
-            if (inParams.melodiaTrick) {
-                remaining_energy_index.emplace_back(
-                    _pg_index {&remaining_energy[frame_idx][note_idx], frame_idx, note_idx});
-            }
-
             // equivalent to argrelmax logic
             auto prev = (frame_idx <= 0) ? onset : onsets[frame_idx - 1][note_idx];
             auto next = (frame_idx >= last_frame) ? onset : onsets[frame_idx + 1][note_idx];
@@ -90,7 +92,7 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
             int i = frame_idx + 1;
             int k = 0; // number of frames since energy dropped below threshold
             while (i < last_frame && k < inParams.energyThreshold) {
-                if (remaining_energy[i][note_idx] < frame_threshold) {
+                if (remaining_energy(i, note_idx) < frame_threshold) {
                     k++;
                 } else {
                     k = 0;
@@ -107,15 +109,8 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
 
             double amplitude = 0.0;
             for (int f = frame_idx; f < i; f++) {
-                amplitude += remaining_energy[f][note_idx];
-                remaining_energy[f][note_idx] = 0;
-
-                if (note_idx < MAX_NOTE_IDX) {
-                    remaining_energy[f][note_idx + 1] = 0;
-                }
-                if (note_idx > 0) {
-                    remaining_energy[f][note_idx - 1] = 0;
-                }
+                amplitude += remaining_energy(f, note_idx);
+                zero_energy(f, note_idx);
             }
             amplitude /= (i - frame_idx);
 
@@ -131,9 +126,22 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
     }
 
     if (inParams.melodiaTrick) {
+        // Index of the energy left once the first pass is done. Cells at or below frame_threshold would stop the loop
+        // below, and the energy of a cell only ever drops to 0, so only the ones above it are indexed and sorted.
+        // That's usually a small part of the n_frames * n_notes cells.
+        std::vector<_pg_index> remaining_energy_index;
+        for (int frame_idx = last_frame - 1; frame_idx >= 0; frame_idx--) {
+            const float* energy_row = inNotesPG[frame_idx];
+            const uint8_t* used_row = energy_used[frame_idx];
+            for (int note_idx = max_note_idx; note_idx >= min_note_idx; note_idx--) {
+                if (!used_row[note_idx] && energy_row[note_idx] > frame_threshold) {
+                    remaining_energy_index.emplace_back(_pg_index {energy_row[note_idx], frame_idx, note_idx});
+                }
+            }
+        }
         std::sort(remaining_energy_index.begin(),
                   remaining_energy_index.end(),
-                  [](const _pg_index& a, const _pg_index& b) { return *a.value > *b.value; });
+                  [](const _pg_index& a, const _pg_index& b) { return a.value > b.value; });
 
         // loop through each remaining note probability in descending order
         // until reaching frame_threshold.
@@ -141,7 +149,7 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
             auto rei = remaining_energy_index[r];
             auto& frame_idx = rei.frameIdx;
             auto& note_idx = rei.noteIdx;
-            auto& energy = *rei.value;
+            auto energy = remaining_energy(frame_idx, note_idx);
 
             // skip those that have already been zeroed
             if (energy == 0) {
@@ -151,33 +159,26 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
             if (energy <= frame_threshold) {
                 break;
             }
-            energy = 0;
+            energy_used[frame_idx][note_idx] = 1;
 
             // this inhibit function zeroes out neighbor notes and keeps track (with k)
             // on how many consecutive frames were below frame_threshold.
-            auto inhibit =
-                [](std::vector<std::vector<float>>& pg, int frame_idx, int note_idx, float frame_threshold, int k) {
-                    if (pg[frame_idx][note_idx] < frame_threshold) {
-                        k++;
-                    } else {
-                        k = 0;
-                    }
-
-                    pg[frame_idx][note_idx] = 0;
-                    if (note_idx < MAX_NOTE_IDX) {
-                        pg[frame_idx][note_idx + 1] = 0;
-                    }
-                    if (note_idx > 0) {
-                        pg[frame_idx][note_idx - 1] = 0;
-                    }
-                    return k;
-                };
+            auto inhibit = [&](int frame_idx, int note_idx, int k) {
+                if (remaining_energy(frame_idx, note_idx) < frame_threshold) {
+                    k++;
+                } else {
+                    k = 0;
+                }
+
+                zero_energy(frame_idx, note_idx);
+                return k;
+            };
 
             // forward pass
             int i = frame_idx + 1;
             int k = 0;
             while (i < last_frame && k < inParams.energyThreshold) {
-                k = inhibit(remaining_energy, i, note_idx, frame_threshold, k);
+                k = inhibit(i, note_idx, k);
                 i++;
             }
 
@@ -187,7 +188,7 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
             i = frame_idx - 1;
             k = 0;
             while (i > 0 && k < inParams.energyThreshold) {
-                k = inhibit(remaining_energy, i, note_idx, frame_threshold, k);
+                k = inhibit(i, note_idx, k);
                 i--;
             }
 
@@ -228,7 +229,7 @@ std::vector<Notes::Event> Notes::convert(const std::vector<std::vector<float>>&
 }
 
 void Notes::_addPitchBends(std::vector<Notes::Event>& inOutEvents,
-                           const std::vector<std::vector<float>>& inContoursPG,
+                           const Utils::Matrix<float>& inContoursPG,
                            int inNumBinsTolerance)
 {
     auto window_length = inNumBinsTolerance * 2 + 1;
@@ -12,6 +12,7 @@
 #include <algorithm>
 
 #include "BasicPitchConstants.h"
+#include "Utils/Matrix.h"
 
 enum PitchBendModes { NoPitchBend = 0, SinglePitchBend, MultiPitchBend };
 
@@ -56,9 +57,9 @@ public:
      * @param inParams input parameters
      * @return
      */
-    std::vector<Notes::Event> convert(const std::vector<std::vector<float>>& inNotesPG,
-                                      const std::vector<std::vector<float>>& inOnsetsPG,
-                                      const std::vector<std::vector<float>>& inContoursPG,
+    std::vector<Notes::Event> convert(const Utils::Matrix<float>& inNotesPG,
+                                      const Utils::Matrix<float>& inOnsetsPG,
+                                      const Utils::Matrix<float>& inContoursPG,
                                       ConvertParams inParams);
 
     /**
@@ -123,7 +124,7 @@ public:
 
 private:
     typedef struct {
-        float* value;
+        float value; // remaining energy when the index was made
         int frameIdx;
         int noteIdx;
     } _pg_index;
@@ -135,7 +136,7 @@ private:
      * @param inNumBinsTolerance
      */
     void _addPitchBends(std::vector<Notes::Event>& inOutEvents,
-                        const std::vector<std::vector<float>>& inContoursPG,
+                        const Utils::Matrix<float>& inContoursPG,
                         int inNumBinsTolerance = 25);
 
     /**
@@ -177,18 +178,19 @@ private:
      */
     // TODO: change to float
     template <typename T>
-    static std::vector<std::vector<T>> _inferredOnsets(const std::vector<std::vector<T>>& inOnsetsPG,
-                                                       const std::vector<std::vector<T>>& inNotesPG,
-                                                       int inNumDiffs = 2)
+    static Utils::Matrix<T> _inferredOnsets(const Utils::Matrix<T>& inOnsetsPG,
+                                            const Utils::Matrix<T>& inNotesPG,
+                                            int inNumDiffs = 2)
     {
-        auto n_frames = inNotesPG.size();
-        auto n_notes = inNotesPG[0].size();
+        auto n_frames = inNotesPG.getNumRows();
+        auto n_notes = inNotesPG.getNumCols();
 
         // The algorithm starts by calculating a diff of note posteriorgrams, hence the name notes_diff.
         // This same variable will later morph into the inferred onsets output
         // notes_diff needs to be initialized to all 1 to not interfere with minima
         // calculations, assuming all values in inNotesPG are probabilities < 1.
-        auto notes_diff = std::vector<std::vector<T>>(n_frames, std::vector<T>(n_notes, 1));
+        auto notes_diff = Utils::Matrix<T>(n_frames, n_notes);
+        notes_diff.fill(1);
 
         // max of minima of notes_diff
         T max_min_notes_diff = 0;
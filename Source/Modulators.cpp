@@ -25,19 +25,26 @@ const std::array<const LFOModSource::Shape, LFOModSource::NUM_LFO_SHAPES> LFOMod
 
 void LFOModSource::processBlock() {
   // Calculate LFO output
-  mOutput = LFO_SHAPES[shape->getIndex()].calc(mCurPhase) / 2.0f;
-  if (!bipolar->get()) mOutput = mOutput + 0.5f; // Make unipolar if needed
+  mOutput = calcOutput(mCurPhase);
 
   // Update phase for the next block
+  mCurPhase += getPhaseIncrement();
+
+  // Wrap phase to keep it in the range [0, 2PI)
+  if (mCurPhase >= juce::MathConstants<double>::twoPi) mCurPhase -= juce::MathConstants<double>::twoPi;
+}
+
+double LFOModSource::getPhaseIncrement() {
   if (sync->get()) {
     const float divInBars = std::pow(2, juce::roundToInt(ParamRanges::SYNC_DIV_MAX * rate->convertTo0to1(rate->get())));
-    mCurPhase += mRadPerBlock / (mBarsPerSec / divInBars);
-  } else {
-    mCurPhase += mRadPerBlock * rate->get();
+    return mRadPerBlock / (mBarsPerSec / divInBars);
   }
+  return mRadPerBlock * rate->get();
+}
 
-  // Wrap phase to keep it in the range [0, 2PI)
-  if (mCurPhase >= juce::MathConstants<double>::twoPi) mCurPhase -= juce::MathConstants<double>::twoPi;
+float LFOModSource::calcOutput(double phaseRad) {
+  const float output = LFO_SHAPES[shape->getIndex()].calc(phaseRad) / 2.0f;
+  return bipolar->get() ? output : output + 0.5f; // Make unipolar if needed
 }
 
 juce::Range<float> LFOModSource::getRange() {
@@ -61,6 +68,114 @@ juce::Range<float> EnvModSource::getRange() {
   return juce::Range<float>(0.0f, 1.0f);
 }
 
+VoiceModSources::VoiceModSources(std::array<LFOModSource, NUM_LFOS>& lfos, std::array<EnvModSource, NUM_MOD_ENVS>& envs)
+    : mLFOs(lfos), mEnvs(envs) {
+  mIsAllocated.fill(false);
+  mHeldSamples.fill(0.0f);
+  mReleasedSamples.fill(-1.0f);
+  for (int i = 0; i < NUM_MOD_ENVS; ++i) {
+    mEnvNoteOffAmp[i].fill(0.0f);
+    mEnvOutput[i].fill(0.0f);
+  }
+  for (int i = 0; i < NUM_LFOS; ++i) {
+    mLFOPhase[i].fill(0.0);
+    mLFOOutput[i].fill(0.0f);
+  }
+}
+
+void VoiceModSources::prepare(int blockSize, double sampleRate) {
+  mBlockSize = blockSize;
+  mSampleRate = sampleRate;
+}
+
+void VoiceModSources::processBlock() {
+  // Every slot is updated, free or not, so the inner loops stay branch free over contiguous arrays
+  for (int envIdx = 0; envIdx < NUM_MOD_ENVS; ++envIdx) {
+    EnvModSource& env = mEnvs[envIdx];
+    // Same math as Utils::EnvelopeADSR, written in closed form from the elapsed samples instead of a state machine
+    const float attack = env.attack->get() * mSampleRate;
+    const float decay = env.decay->get() * mSampleRate;
+    const float sustain = env.sustain->get();
+    const float release = env.release->get() * mSampleRate;
+    const float* noteOffAmp = mEnvNoteOffAmp[envIdx].data();
+    float* output = mEnvOutput[envIdx].data();
+    for (int v = 0; v < MAX_VOICES; ++v) {
+      const float t = mHeldSamples[v];
+      const float held = (t < attack) ? t / attack : ((t - attack < decay) ? 1.0f - ((t - attack) / decay) * (1.0f - sustain) : sustain);
+      const float released = juce::jmax(0.0f, noteOffAmp[v] - ((mReleasedSamples[v] / release) * noteOffAmp[v]));
+      output[v] = (mReleasedSamples[v] < 0.0f) ? held : released;
+    }
+  }
+
+  for (int lfoIdx = 0; lfoIdx < NUM_LFOS; ++lfoIdx) {
+    LFOModSource& lfo = mLFOs[lfoIdx];
+    const double increment = lfo.getPhaseIncrement();
+    double* phase = mLFOPhase[lfoIdx].data();
+    float* output = mLFOOutput[lfoIdx].data();
+    for (int v = 0; v < MAX_VOICES; ++v) {
+      output[v] = lfo.calcOutput(phase[v]);
+      phase[v] += increment;
+      if (phase[v] >= juce::MathConstants<double>::twoPi) phase[v] -= juce::MathConstants<double>::twoPi;
+    }
+  }
+
+  for (int v = 0; v < MAX_VOICES; ++v) {
+    mHeldSamples[v] += mBlockSize;
+    if (mReleasedSamples[v] >= 0.0f) mReleasedSamples[v] += mBlockSize;
+  }
+}
+
+int VoiceModSources::allocateVoice() {
+  for (int v = 0; v < MAX_VOICES; ++v) {
+    if (!mIsAllocated[v]) {
+      mIsAllocated[v] = true;
+      return v;
+    }
+  }
+  return -1;
+}
+
+void VoiceModSources::freeVoice(int voice) {
+  if (voice >= 0 && voice < MAX_VOICES) mIsAllocated[voice] = false;
+}
+
+void VoiceModSources::noteOn(int voice) {
+  if (voice < 0 || voice >= MAX_VOICES) return;
+  mHeldSamples[voice] = 0.0f;
+  mReleasedSamples[voice] = -1.0f;
+  // Outputs are set right away as the note can start rendering before the next processBlock()
+  for (int envIdx = 0; envIdx < NUM_MOD_ENVS; ++envIdx) {
+    mEnvNoteOffAmp[envIdx][voice] = 0.0f;
+    mEnvOutput[envIdx][voice] = 0.0f;
+  }
+  for (int lfoIdx = 0; lfoIdx < NUM_LFOS; ++lfoIdx) {
+    mLFOPhase[lfoIdx][voice] = mLFOs[lfoIdx].phase->get();
+    mLFOOutput[lfoIdx][voice] = mLFOs[lfoIdx].calcOutput(mLFOPhase[lfoIdx][voice]);
+  }
+}
+
+void VoiceModSources::noteOff(int voice) {
+  if (voice < 0 || voice >= MAX_VOICES || mReleasedSamples[voice] >= 0.0f) return;
+  mReleasedSamples[voice] = 0.0f;
+  for (int envIdx = 0; envIdx < NUM_MOD_ENVS; ++envIdx) {
+    mEnvNoteOffAmp[envIdx][voice] = mEnvOutput[envIdx][voice];
+  }
+}
+
+float VoiceModSources::getOutput(ModSource* source, int voice) {
+  if (voice < 0 || voice >= MAX_VOICES) return source->getOutput();
+  switch (source->getType()) {
+    case ModSourceType::ENV:
+      return mEnvOutput[source->getIdx()][voice];
+    case ModSourceType::LFO: {
+      LFOModSource& lfo = mLFOs[source->getIdx()];
+      return lfo.retrigger->get() ? mLFOOutput[source->getIdx()][voice] : lfo.getOutput();
+    }
+    default:
+      return source->getOutput();
+  }
+}
+
 void MacroModSource::processBlock() {
   // Use macro value as output
   mOutput = macro->get();
@@ -25,6 +25,10 @@ enum ModSourceType {
   MACRO
 };
 
+static constexpr int NUM_LFOS = 3;
+static constexpr int NUM_MOD_ENVS = 2;
+static constexpr int NUM_MACROS = 4;
+
 // Base class for modulator sources.. processBlock() should be called once per block and the output can be grabbed with getOutput()
 class ModSource {
 public:
@@ -86,6 +90,11 @@ public:
   void setSyncRate(float barsPerSec) { mBarsPerSec = barsPerSec; }
   void checkRetrigger() { if (retrigger && retrigger->get()) mCurPhase = phase->get(); }
 
+  // Phase (in radians) the LFO moves forward each block given the current rate and sync settings
+  double getPhaseIncrement();
+  // LFO output at the given phase using the current shape and polarity
+  float calcOutput(double phaseRad);
+
   // Must be initialized externally (in this app done in Parameters.cpp)
   juce::AudioParameterChoice* shape;
   juce::AudioParameterFloat* rate;
@@ -144,6 +153,45 @@ private:
   int mCurTs = 0;
 };
 
+/* Per-voice state of the LFO and envelope mod sources.
+ The sources above hold a single state, so each note on retriggers the one envelope shared by every held note. Here each note
+ gets its own voice slot instead. The state is stored voice-major as one flat array per field (indexed by voice) so a block
+ updates all voices with a few tight loops, and the processBlock() cost does not depend on how many notes are held.
+ Macros and free running (non retriggered) LFOs are the same for every voice and keep using the global output.
+ */
+class VoiceModSources {
+public:
+  static constexpr int MAX_VOICES = 16;
+
+  VoiceModSources(std::array<LFOModSource, NUM_LFOS>& lfos, std::array<EnvModSource, NUM_MOD_ENVS>& envs);
+
+  void prepare(int blockSize, double sampleRate);
+  void processBlock();
+
+  // Returns a free voice slot, or -1 if all are used (the note then just follows the global sources)
+  int allocateVoice();
+  void freeVoice(int voice);
+  void noteOn(int voice);
+  void noteOff(int voice);
+
+  // Output of the source for a voice, voice of -1 returns the global output
+  float getOutput(ModSource* source, int voice);
+
+private:
+  std::array<LFOModSource, NUM_LFOS>& mLFOs;
+  std::array<EnvModSource, NUM_MOD_ENVS>& mEnvs;
+  double mSampleRate = 48000;
+  int mBlockSize = 512;
+
+  std::array<bool, MAX_VOICES> mIsAllocated;
+  std::array<float, MAX_VOICES> mHeldSamples;     // Samples since note on
+  std::array<float, MAX_VOICES> mReleasedSamples; // Samples since note off, negative while the note is held
+  std::array<std::array<float, MAX_VOICES>, NUM_MOD_ENVS> mEnvNoteOffAmp;
+  std::array<std::array<float, MAX_VOICES>, NUM_MOD_ENVS> mEnvOutput;
+  std::array<std::array<double, MAX_VOICES>, NUM_LFOS> mLFOPhase;
+  std::array<std::array<float, MAX_VOICES>, NUM_LFOS> mLFOOutput;
+};
+
 // Macro modulation source
 class MacroModSource : public ModSource {
 public:
@@ -0,0 +1,278 @@
+/*
+  ==============================================================================
+
+    ParamJournal.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+/**
+ * Log of parameter changes, keyed by the Parameters::getParamIndex() index.
+ * Every parameter gets a Tap listener that pushes {index, value} from whatever thread changed it. The message thread drains
+ * the log to update what depends on the changed parameters only, and keeps the user edits as undo/redo steps.
+ * The message thread writes to a fifo of its own. Every other thread (the audio thread, host automation wherever the wrapper
+ * applies it, host state, the analysis) shares a fifo that takes any number of writers without locking.
+ */
+class ParamJournal {
+ public:
+  static constexpr int FIFO_SIZE = 4096;
+  static constexpr int MAX_UNDO_STEPS = 256;
+  // Consecutive steps editing the same parameter within this time are merged, so a slider drag is a single undo
+  static constexpr juce::uint32 MERGE_MS = 1000;
+
+  struct Entry {
+    int idx;
+    float value;
+    bool isHost;  // Pushed from a thread other than the message thread, ie host automation
+  };
+
+  struct Change {
+    int idx;
+    float before;
+    float after;
+    bool usedBefore;
+    bool usedAfter;
+  };
+  using Step = std::vector<Change>;
+
+  ~ParamJournal() { detach(); }
+
+  // Listens to all params, index in the array is the journal index
+  void attach(const juce::Array<juce::RangedAudioParameter*>& params) {
+    detach();
+    for (int i = 0; i < params.size(); ++i) {
+      mTaps.add(new Tap(*this, *params[i], i));
+    }
+    mLastValues.resize(params.size(), 0.0f);
+    mLastUsed.resize(params.size(), false);
+    invalidate();
+  }
+  void detach() { mTaps.clear(); }
+
+  // Any thread, never blocks
+  void push(int idx, float value) {
+    mVersion++;
+    const bool isMessageThread = juce::MessageManager::existsAndIsCurrentThread();
+    if (isMessageThread && mIsReplaying) return;  // Undo/redo keep the history themselves
+    const Entry entry = {idx, value, !isMessageThread};
+    const bool isWritten = isMessageThread ? mMessageFifo.write(entry) : mHostFifo.write(entry);
+    // Full, the message thread will resync instead
+    if (!isWritten) mIsValid.store(false);
+  }
+
+  // Drops anything pending and the history, next drain() returns false so the owner can resync with setBaseline()
+  void invalidate() {
+    mVersion++;
+    mIsValid.store(false);
+  }
+
+  // Bumped by every push() and invalidate(), including the ones undo/redo cause
+  juce::uint32 getVersion() const { return mVersion.load(); }
+
+  // Message thread, the last known value and isUsed state an index is undone to
+  void setBaseline(int idx, float value, bool isUsed) {
+    mLastValues[idx] = value;
+    mLastUsed[idx] = isUsed;
+  }
+
+  /**
+   * Message thread. Calls fn(entry) for every pending change, fn returns the isUsed state of the parameter after applying
+   * it. The user changes drained together become one undo step.
+   * Returns false if changes were lost (overflow or invalidate()), in that case nothing was applied and the history is
+   * cleared so the caller has to set the baseline again.
+   */
+  template <typename Fn>
+  bool drain(Fn&& fn) {
+    if (!mIsValid.exchange(true)) {
+      // Can't reset() while the other side might be writing, read everything out instead
+      mMessageFifo.read([](const Entry&) {});
+      mHostFifo.read([](const Entry&) {});
+      mUndo.clear();
+      mRedo.clear();
+      return false;
+    }
+
+    Step step;
+    const auto apply = [&](const Entry& entry) {
+      const bool isUsed = fn(entry);
+      if (!entry.isHost) {
+        step.push_back({entry.idx, mLastValues[entry.idx], entry.value, mLastUsed[entry.idx], isUsed});
+      }
+      mLastValues[entry.idx] = entry.value;
+      mLastUsed[entry.idx] = isUsed;
+    };
+    mMessageFifo.read(apply);
+    mHostFifo.read(apply);
+    if (!step.empty()) addStep(std::move(step));
+    return true;
+  }
+
+  bool canUndo() const { return !mUndo.empty(); }
+  bool canRedo() const { return !mRedo.empty(); }
+
+  // Message thread, applyFn(change, isUndo) is called for each change of the step in the order to apply them
+  template <typename Fn>
+  bool undo(Fn&& applyFn) {
+    if (mUndo.empty()) return false;
+    Step step = std::move(mUndo.back());
+    mUndo.pop_back();
+    replay(step, true, applyFn);
+    mRedo.push_back(std::move(step));
+    return true;
+  }
+  template <typename Fn>
+  bool redo(Fn&& applyFn) {
+    if (mRedo.empty()) return false;
+    Step step = std::move(mRedo.back());
+    mRedo.pop_back();
+    replay(step, false, applyFn);
+    mUndo.push_back(std::move(step));
+    return true;
+  }
+
+ private:
+  class Tap : public juce::AudioProcessorParameter::Listener {
+   public:
+    Tap(ParamJournal& journal, juce::AudioProcessorParameter& param, int idx) : mJournal(journal), mParam(param), mIdx(idx) {
+      mParam.addListener(this);
+    }
+    ~Tap() override { mParam.removeListener(this); }
+
+    // The index passed in is -1 for params the host doesn't know about, use our own
+    void parameterValueChanged(int, float newValue) override { mJournal.push(mIdx, newValue); }
+    void parameterGestureChanged(int, bool) override {}
+
+   private:
+    ParamJournal& mJournal;
+    juce::AudioProcessorParameter& mParam;
+    const int mIdx;
+  };
+
+  // Single writer, single reader
+  class Fifo {
+   public:
+    bool write(const Entry& entry) {
+      auto scope = mFifo.write(1);
+      if (scope.blockSize1 + scope.blockSize2 == 0) return false;
+      scope.forEach([&](int i) { mEntries[i] = entry; });
+      return true;
+    }
+    template <typename Fn>
+    void read(Fn&& fn) {
+      auto scope = mFifo.read(mFifo.getNumReady());
+      scope.forEach([&](int i) { fn(mEntries[i]); });
+    }
+
+   private:
+    juce::AbstractFifo mFifo{FIFO_SIZE};
+    std::array<Entry, FIFO_SIZE> mEntries;
+  };
+
+  // Any number of writers, single reader. Writers claim a slot by moving the write position along with a CAS, each slot's
+  // sequence tells the reader when its entry is written and the writers when it is read (bounded MPMC queue by D. Vyukov)
+  class MultiWriterFifo {
+   public:
+    MultiWriterFifo() {
+      for (size_t i = 0; i < (size_t)FIFO_SIZE; ++i) mSlots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool write(const Entry& entry) {
+      size_t pos = mWritePos.load(std::memory_order_relaxed);
+      for (;;) {
+        Slot& slot = mSlots[pos & MASK];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+        if (diff == 0) {
+          if (mWritePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+            slot.entry = entry;
+            slot.sequence.store(pos + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (diff < 0) {
+          return false;  // Full
+        } else {
+          pos = mWritePos.load(std::memory_order_relaxed);
+        }
+      }
+    }
+    // Stops at the first slot still being written, the rest is read next time
+    template <typename Fn>
+    void read(Fn&& fn) {
+      for (;;) {
+        Slot& slot = mSlots[mReadPos & MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != mReadPos + 1) return;
+        fn(slot.entry);
+        slot.sequence.store(mReadPos + FIFO_SIZE, std::memory_order_release);
+        mReadPos++;
+      }
+    }
+
+   private:
+    static_assert((FIFO_SIZE & (FIFO_SIZE - 1)) == 0, "The position wraps with a mask");
+    static constexpr size_t MASK = FIFO_SIZE - 1;
+    struct Slot {
+      std::atomic<size_t> sequence;
+      Entry entry;
+    };
+    std::array<Slot, FIFO_SIZE> mSlots;
+    alignas(64) std::atomic<size_t> mWritePos{0};
+    alignas(64) size_t mReadPos = 0;
+  };
+
+  void addStep(Step&& step) {
+    mRedo.clear();
+    const juce::uint32 now = juce::Time::getMillisecondCounter();
+    const bool isSingle = std::all_of(step.begin(), step.end(), [&](const Change& c) { return c.idx == step[0].idx; });
+    if (isSingle && !mUndo.empty() && now - mLastStepMs < MERGE_MS) {
+      Step& last = mUndo.back();
+      if (std::all_of(last.begin(), last.end(), [&](const Change& c) { return c.idx == step[0].idx; })) {
+        last.back().after = step.back().after;
+        last.back().usedAfter = step.back().usedAfter;
+        mLastStepMs = now;
+        return;
+      }
+    }
+    mUndo.push_back(std::move(step));
+    if ((int)mUndo.size() > MAX_UNDO_STEPS) mUndo.pop_front();
+    mLastStepMs = now;
+  }
+
+  template <typename Fn>
+  void replay(const Step& step, bool isUndo, Fn&& applyFn) {
+    mIsReplaying = true;
+    if (isUndo) {
+      for (auto it = step.rbegin(); it != step.rend(); ++it) {
+        applyFn(*it, true);
+        setBaseline(it->idx, it->before, it->usedBefore);
+      }
+    } else {
+      for (const Change& change : step) {
+        applyFn(change, false);
+        setBaseline(change.idx, change.after, change.usedAfter);
+      }
+    }
+    mIsReplaying = false;
+  }
+
+  Fifo mMessageFifo;
+  MultiWriterFifo mHostFifo;  // Every thread but the message thread
+  std::atomic<bool> mIsValid{false};
+  std::atomic<juce::uint32> mVersion{0};
+  bool mIsReplaying = false;
+
+  juce::OwnedArray<Tap> mTaps;
+  std::vector<float> mLastValues;
+  std::vector<bool> mLastUsed;
+  std::deque<Step> mUndo;
+  std::deque<Step> mRedo;
+  juce::uint32 mLastStepMs = 0;
+};
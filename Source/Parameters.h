@@ -17,6 +17,9 @@
 #include "Utils/Colour.h"
 #include "Utils/PitchClass.h"
 #include "Modulators.h"
+#include "ParamJournal.h"
+#include "Preset.h"
+#include <unordered_map>
 
 // Dynamically casts to AudioParameterFloat*
 #define P_FLOAT(X) dynamic_cast<juce::AudioParameterFloat*>(X)
@@ -191,10 +194,172 @@ namespace ParamHelper {
   }
 }
 
+/**
+ * Host facing stand-in for any parameter, so one that isn't given to the host can still be automated. The slots are always
+ * there whatever they are assigned to, so the host's parameter list only depends on the compact mode and which parameter a
+ * slot drives is saved with the session.
+ */
+class HostSlotParam : public juce::AudioParameterFloat, private juce::AudioProcessorParameter::Listener {
+ public:
+  HostSlotParam(int slot)
+      : juce::AudioParameterFloat({"hostSlot" + juce::String(slot), 1}, "Slot " + juce::String(slot + 1), 0.0f, 1.0f, 0.0f),
+        mSlot(slot) {}
+  ~HostSlotParam() override { jassert(mTarget.load() == nullptr); }
+
+  // Message thread, nullptr to clear the slot
+  void setTarget(juce::RangedAudioParameter* target) {
+    if (auto* oldTarget = mTarget.load()) oldTarget->removeListener(this);
+    mTarget = target;
+    if (target != nullptr) {
+      target->addListener(this);
+      parameterValueChanged(-1, target->getValue());
+    }
+  }
+  juce::RangedAudioParameter* getTarget() const { return mTarget.load(); }
+  // The target was set without notifying its listeners, takes its value without telling the host either
+  void syncToTarget() {
+    if (auto* target = mTarget.load()) juce::AudioParameterFloat::setValue(target->getValue());
+  }
+
+  juce::String getName(int maximumStringLength) const override {
+    auto* target = mTarget.load();
+    juce::String name = "Slot " + juce::String(mSlot + 1);
+    if (target != nullptr) name += ": " + target->getName(maximumStringLength);
+    return name.substring(0, maximumStringLength);
+  }
+
+  // The host changed the slot, the change goes to the target. Both sides skip equal values so they don't bounce back
+  void setValue(float newValue) override {
+    juce::AudioParameterFloat::setValue(newValue);
+    auto* target = mTarget.load();
+    if (target != nullptr && target->getValue() != newValue) target->setValueNotifyingHost(newValue);
+  }
+
+ private:
+  // The target changed (UI, presets, the host through another slot), let the host know
+  void parameterValueChanged(int, float newValue) override {
+    if (getValue() != newValue) setValueNotifyingHost(newValue);
+  }
+  void parameterGestureChanged(int, bool) override {}
+
+  const int mSlot;
+  std::atomic<juce::RangedAudioParameter*> mTarget{nullptr};
+};
+
+/**
+ * Hands parameters to the processor as they are created.
+ * In compact mode only the global parameters and the host slots are given to the host, hosts have to enumerate, poll and
+ * save every parameter and the ~1000 per note/generator ones make scanning and project loads slow. The rest are owned here,
+ * work the same for the synth and UI, and are still saved with the preset.
+ */
+class ParamRegistry {
+ public:
+  static constexpr int NUM_HOST_SLOTS = 16;
+
+  ~ParamRegistry() {
+    // The processor deletes the slots after the parameters they point to are gone
+    for (auto* slot : mHostSlots) slot->setTarget(nullptr);
+  }
+
+  void init(juce::AudioProcessor& processor, bool isCompact) {
+    mProcessor = &processor;
+    mIsCompact = isCompact;
+  }
+
+  void add(juce::RangedAudioParameter* param, bool isGlobal = false) {
+    jassert(mProcessor != nullptr);
+    mIndices[param] = mAll.size();
+    mAll.add(param);
+    if (!mIsCompact || isGlobal) {
+      mProcessor->addParameter(param);
+    } else {
+      mInternal.add(param);
+    }
+  }
+
+  // After all the other parameters, in both modes so sessions automating the slots work in either
+  void addHostSlots() {
+    for (int i = 0; i < NUM_HOST_SLOTS; ++i) {
+      mHostSlots.add(new HostSlotParam(i));
+      mProcessor->addParameter(mHostSlots.getLast());
+    }
+  }
+
+  bool isCompact() const { return mIsCompact; }
+  // All parameters (host facing or internal) in the order they were added, not including the host slots
+  const juce::Array<juce::RangedAudioParameter*>& getAll() const { return mAll; }
+  // Index of the parameter in the full layout. Same as getParameterIndex() when not compact, so indices saved in presets
+  // (modulations) mean the same thing in both modes
+  int getIndex(const juce::AudioProcessorParameter* param) const {
+    if (!mIsCompact) return param->getParameterIndex();
+    auto it = mIndices.find(param);
+    return (it != mIndices.end()) ? it->second : -1;
+  }
+
+  // Message thread, param is nullptr to clear the slot
+  void setHostSlot(int slot, juce::RangedAudioParameter* param) {
+    mHostSlots[slot]->setTarget(param);
+    // The slot names changed
+    mProcessor->updateHostDisplay(juce::AudioProcessor::ChangeDetails().withParameterInfoChanged(true));
+  }
+  // -1 if the parameter isn't in a slot
+  int getHostSlot(const juce::RangedAudioParameter* param) const {
+    for (int i = 0; i < mHostSlots.size(); ++i) {
+      if (mHostSlots[i]->getTarget() == param) return i;
+    }
+    return -1;
+  }
+  // -1 if they are all taken
+  int getFreeHostSlot() const { return getHostSlot(nullptr); }
+
+  juce::XmlElement* getHostSlotsXml() const {
+    juce::XmlElement* xml = new juce::XmlElement("HostSlots");
+    xml->setAttribute("compact", mIsCompact);  // The layout the session was saved with
+    for (int i = 0; i < mHostSlots.size(); ++i) {
+      if (auto* target = mHostSlots[i]->getTarget()) xml->setAttribute("slot" + juce::String(i), target->paramID);
+    }
+    return xml;
+  }
+  // Missing slots are cleared, xml can be nullptr for sessions from before there were slots
+  void setHostSlotsXml(const juce::XmlElement* xml) {
+    // Sessions from before there were slots were saved with every parameter given to the host
+    const bool isSavedCompact = xml != nullptr && xml->getBoolAttribute("compact");
+    mIsRestoredLayoutMissing = mIsCompact && !isSavedCompact;
+    for (int i = 0; i < mHostSlots.size(); ++i) {
+      const juce::String paramID = xml != nullptr ? xml->getStringAttribute("slot" + juce::String(i)) : juce::String();
+      juce::RangedAudioParameter* target = nullptr;
+      for (auto* param : mAll) {
+        if (paramID.isNotEmpty() && param->paramID == paramID) target = param;
+      }
+      mHostSlots[i]->setTarget(target);
+    }
+    mProcessor->updateHostDisplay(juce::AudioProcessor::ChangeDetails().withParameterInfoChanged(true));
+  }
+  // Message thread, after parameter values were set without notifications. Hosts read the values again
+  void paramsRestored() {
+    for (auto* slot : mHostSlots) slot->syncToTarget();
+    mProcessor->updateHostDisplay(juce::AudioProcessor::ChangeDetails().withParameterInfoChanged(true));
+  }
+  // The last setHostSlotsXml() was saved with host parameters this layout doesn't have, their automation isn't played
+  bool isRestoredLayoutMissing() const { return mIsRestoredLayoutMissing; }
+
+ private:
+  juce::AudioProcessor* mProcessor = nullptr;
+  bool mIsCompact = false;
+  std::atomic<bool> mIsRestoredLayoutMissing{false};
+  juce::Array<juce::RangedAudioParameter*> mAll;
+  juce::OwnedArray<juce::RangedAudioParameter> mInternal;
+  juce::Array<HostSlotParam*> mHostSlots;  // Owned by the processor
+  std::unordered_map<const juce::AudioProcessorParameter*, int> mIndices;
+};
+
 // Common parameters types used by each generator, note and globally
 class ParamCommon {
  public:
-  ParamCommon(ParamType _type) : type(_type) { }
+  ParamCommon(ParamType _type) : type(_type) {
+    for (auto& used : isUsed) { used = false; }
+    for (auto& param : resolved) { param = nullptr; }
+  }
   virtual ~ParamCommon() { }
 
   enum Type {
@@ -263,11 +428,26 @@ class ParamCommon {
     ParamHelper::setParam(P_BOOL(common[GRAIN_SYNC]), ParamDefaults::GRAIN_SYNC_DEFAULT);
     ParamHelper::setParam(P_BOOL(common[REVERSE]), ParamDefaults::REVERSE_DEFAULT);
     ParamHelper::setParam(P_INT(common[OCTAVE_ADJUST]), ParamDefaults::OCTAVE_ADJUST_DEFAULT);
-    for (auto& used : isUsed) { used = false; }
+    for (int i = 0; i < Type::NUM_COMMON; ++i) { setUsed((Type)i, false); }
+  }
+
+  // Always set isUsed through here so the resolved params of this level and the ones below stay in sync
+  void setUsed(Type t, bool used) {
+    isUsed[t] = used;
+    resolve(t);
+  }
+  void resolve(Type t) {
+    resolved[t] = (isUsed[t] || parent == nullptr) ? common[t] : parent->resolved[t];
+    for (ParamCommon* child : children) child->resolve(t);
   }
 
   juce::RangedAudioParameter* common[Type::NUM_COMMON];
   bool isUsed[Type::NUM_COMMON]; // Flag for each parameter set to true when changed from its default
+  // Resolution table, the lowest level param that's used for each type (what Parameters::getUsedParam() returns)
+  juce::RangedAudioParameter* resolved[Type::NUM_COMMON];
+  // Level above (global for notes, note for generators) and below
+  ParamCommon* parent = nullptr;
+  std::vector<ParamCommon*> children;
 
   // Type of derived class
   ParamType type;
@@ -310,7 +490,7 @@ static juce::NormalisableRange<float> COMMON_RANGES[ParamCommon::Type::NUM_COMMO
 namespace ParamHelper {
 [[maybe_unused]] static void setCommonParam(ParamCommon* common, ParamCommon::Type type, float newValue) {
   ParamHelper::setParam(common->common[type], newValue);
-  common->isUsed[type] = true;
+  common->setUsed(type, true);
 }
 }
 
@@ -349,7 +529,7 @@ struct ParamGenerator : ParamCommon {
   ParamGenerator(int _noteIdx, int _genIdx) : ParamCommon(ParamType::GENERATOR), noteIdx(_noteIdx), genIdx(_genIdx) {}
   ~ParamGenerator() {}
 
-  void addParams(juce::AudioProcessor& p);
+  void addParams(ParamRegistry& r);
 
   void addListener(juce::AudioProcessorParameter::Listener* listener) {
     ParamCommon::addListener(listener);
@@ -383,6 +563,8 @@ struct ParamNote : ParamCommon {
   ParamNote(int noteIdx_) : ParamCommon(ParamType::NOTE), noteIdx(noteIdx_) {
     for (int i = 0; i < NUM_GENERATORS; ++i) {
       generators.emplace_back(new ParamGenerator(noteIdx, i));
+      generators.back()->parent = this;
+      children.push_back(generators.back().get());
     }
   }
 
@@ -416,7 +598,7 @@ struct ParamNote : ParamCommon {
     }
   }
 
-  void addParams(juce::AudioProcessor& p);
+  void addParams(ParamRegistry& r);
 
   void addListener(juce::AudioProcessorParameter::Listener* listener) {
     ParamCommon::addListener(listener);
@@ -445,6 +627,8 @@ struct ParamNote : ParamCommon {
   bool shouldPlayGenerator(int genIdx);
   ParamCandidate* getCandidate(int genIdx);
   void setStartingCandidatePosition();
+  // After the candidates are made again, only moves the generators whose candidate is gone
+  void keepCandidatePositions();
 
   int noteIdx;
 
@@ -481,7 +665,7 @@ struct ParamsNote {
     }
   }
 
-  void addParams(juce::AudioProcessor& p);
+  void addParams(ParamRegistry& r);
 
   void resetParams() {
     for (auto& note : notes) {
@@ -555,7 +739,7 @@ struct ParamGlobal : ParamCommon {
   }
   ~ParamGlobal() {}
 
-  void addParams(juce::AudioProcessor& p);
+  void addParams(ParamRegistry& r);
 
   void resetParams() {
     ParamCommon::resetParams();
@@ -589,9 +773,9 @@ struct ParamGlobal : ParamCommon {
   juce::AudioParameterFloat* ampEnvRelease;
 
   // Global modulation sources
-  std::array<LFOModSource, 3> modLFOs;
-  std::array<EnvModSource, 2> modEnvs;
-  std::array<MacroModSource, 4> macros;
+  std::array<LFOModSource, NUM_LFOS> modLFOs;
+  std::array<EnvModSource, NUM_MOD_ENVS> modEnvs;
+  std::array<MacroModSource, NUM_MACROS> macros;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParamGlobal)
 };
@@ -605,6 +789,9 @@ struct ParamUI {
   ParamUI() = default;
 
   enum SpecType { INVALID = -1, SPECTROGRAM = 0, HPCP, DETECTED, WAVEFORM, COUNT };
+  // The images are the size of the arc on screen, larger ones in a preset are corrupted
+  static constexpr int MAX_SPEC_IMAGE_SIZE = 1 << 13;
+  static constexpr int COMPRESSION_LEVEL = 3;  // Spec images are mostly flat colour, higher levels barely shrink them
 
   // Get it from the plugin state
   // will only set xml-able items (floats/int/strings)
@@ -618,6 +805,10 @@ struct ParamUI {
       trimRange.setStart(xml->getDoubleAttribute("trimRangeStart"));
       trimRange.setEnd(xml->getDoubleAttribute("trimRangeEnd"));
       specComplete = xml->getBoolAttribute("specComplete");
+      noteSensitivity = (float)xml->getDoubleAttribute("noteSensitivity", DEFAULT_NOTE_SENSITIVITY);
+      splitSensitivity = (float)xml->getDoubleAttribute("splitSensitivity", DEFAULT_SPLIT_SENSITIVITY);
+      minNoteLengthMs = (float)xml->getDoubleAttribute("minNoteLengthMs", DEFAULT_MIN_NOTE_LENGTH_MS);
+      // Only version 0 presets have the images in the XML, newer ones have them in their own chunk
       if (auto images = xml->getChildByName("Images")) {
         for (int i = 0; i < ParamUI::SpecType::COUNT; ++i) {
           juce::String attrName = "image" + juce::String(i);
@@ -629,6 +820,7 @@ struct ParamUI {
             }
           }
         }
+        specImagesChanged();
       }
     }
   }
@@ -643,25 +835,59 @@ struct ParamUI {
     xml->setAttribute("trimRangeStart", trimRange.getStart());
     xml->setAttribute("trimRangeEnd", trimRange.getEnd());
     xml->setAttribute("specComplete", specComplete);
-    juce::XmlElement* images = new juce::XmlElement("Images");
-    for (size_t i = 0; i < ParamUI::SpecType::COUNT; ++i) {
-      juce::MemoryOutputStream out;
-      saveSpecImage(out, i);
-      juce::MemoryBlock imageData(out.getData(), out.getDataSize());
-      images->setAttribute("image" + juce::String(i), imageData.toBase64Encoding());
-    }
-    xml->addChildElement(images);
+    xml->setAttribute("noteSensitivity", noteSensitivity.load());
+    xml->setAttribute("splitSensitivity", splitSensitivity.load());
+    xml->setAttribute("minNoteLengthMs", minNoteLengthMs.load());
     return xml;
   }
 
-  // Save image files
-  bool saveSpecImage(juce::OutputStream& outputStream, size_t index) {
-    juce::PNGImageFormat pngWriter;
-    if (index >= specImages.size() || !specImages[index].isValid()) {
-      DBG("saveSpecImage failed\nindex = " << index << "\nspecImage.size = " << specImages.size());
-      return false;
+  // Pixels of the valid spec images, layout is Preset::CHUNK_IMAGES
+  void writeSpecImages(juce::OutputStream& out) {
+    Preset::ImagesChunk chunk = {};
+    for (auto& image : specImages) {
+      if (image.isValid()) chunk.numImages++;
+    }
+    out.write(&chunk, sizeof(chunk));
+    // The pixels as they are, zlib is much cheaper than encoding PNGs on every save
+    juce::GZIPCompressorOutputStream zip(out, COMPRESSION_LEVEL);
+    for (size_t i = 0; i < specImages.size(); ++i) {
+      if (!specImages[i].isValid()) continue;
+      const juce::Image image = specImages[i].convertedToFormat(juce::Image::ARGB);
+      const Preset::ImageInfo info = {(uint32_t)i, image.getWidth(), image.getHeight(), 0};
+      zip.write(&info, sizeof(info));
+      const juce::Image::BitmapData bitmap(image, juce::Image::BitmapData::readOnly);
+      for (int y = 0; y < image.getHeight(); ++y) {
+        zip.write(bitmap.getLinePointer(y), (size_t)image.getWidth() * sizeof(juce::PixelARGB));
+      }
+    }
+    zip.flush();
+  }
+
+  // Inverse of writeSpecImages(). Returns false if the data is cut short
+  bool readSpecImages(const void* data, size_t size) {
+    juce::MemoryInputStream in(data, size, false);
+    Preset::ImagesChunk chunk;
+    if (in.read(&chunk, sizeof(chunk)) != sizeof(chunk)) return false;
+    juce::GZIPDecompressorInputStream unzip(in);
+    for (uint32_t n = 0; n < chunk.numImages; ++n) {
+      Preset::ImageInfo info;
+      if (unzip.read(&info, sizeof(info)) != sizeof(info)) return false;
+      const size_t lineSize = (size_t)info.width * sizeof(juce::PixelARGB);
+      if (info.specType >= specImages.size() || info.width <= 0 || info.height <= 0 ||
+          info.width > MAX_SPEC_IMAGE_SIZE || info.height > MAX_SPEC_IMAGE_SIZE) {
+        return false;
+      }
+      juce::Image image(juce::Image::ARGB, info.width, info.height, false);
+      {
+        const juce::Image::BitmapData bitmap(image, juce::Image::BitmapData::writeOnly);
+        for (int y = 0; y < info.height; ++y) {
+          if (unzip.read(bitmap.getLinePointer(y), (int)lineSize) != (int)lineSize) return false;
+        }
+      }
+      specImages[info.specType] = image;
     }
-    return pngWriter.writeImageToStream(specImages[index], outputStream);
+    specImagesChanged();
+    return true;
   }
 
   juce::String fileName = "-- init --";        // currently being viewed
@@ -672,10 +898,24 @@ struct ParamUI {
   // ArcSpectrogram related items
   SpecType specType = ParamUI::SpecType::INVALID;
   std::array<juce::Image, SpecType::COUNT> specImages;
+  // Call after writing to specImages, lets the saved state know the images it has are stale
+  void specImagesChanged() { specImagesVersion++; }
+  std::atomic<juce::uint32> specImagesVersion{0};
   // Where ArcSpectrogram can let others know when it is "complete"
   // Makes no sense to save to preset file
   bool specComplete = false;
   bool isLoading = false;
+  // SPECTROGRAM has the log spaced bins of the pitch detection CQT (Utils::getSpecsFromFeatures()), not the FFT ones
+  std::atomic<bool> isSpecLogFrequency{false};
+
+  // Note detection, what the notes are made from the transcription with (see BasicPitch::setParameters()).
+  // The defaults make the same notes as Notes::ConvertParams does
+  static constexpr float DEFAULT_NOTE_SENSITIVITY = 0.5f;
+  static constexpr float DEFAULT_SPLIT_SENSITIVITY = 0.7f;
+  static constexpr float DEFAULT_MIN_NOTE_LENGTH_MS = 128.0f;
+  std::atomic<float> noteSensitivity{DEFAULT_NOTE_SENSITIVITY};
+  std::atomic<float> splitSensitivity{DEFAULT_SPLIT_SENSITIVITY};
+  std::atomic<float> minNoteLengthMs{DEFAULT_MIN_NOTE_LENGTH_MS};
 
   // Tracks what component is being displayed
   enum class CenterComponent { ARC_SPEC, TRIM_SELECTION };
@@ -688,7 +928,7 @@ struct ParamUI {
 
 };
 
-class Parameters {
+class Parameters : private juce::AsyncUpdater, private juce::Timer {
 public:
   class Listener
   {
@@ -698,21 +938,50 @@ public:
     virtual void selectedCommonParamsChanged(ParamCommon* newParams) {}
     // Called when the current modulator mapping source changes
     virtual void mappingSourceChanged(ModSource* mod) {}
+    // Called once on the message thread after restoreParams() replaced the parameter values
+    virtual void paramsRestored() {}
+    // Called when isUsed flags changed outside of the UI, ie from automation or undo/redo
+    virtual void usedParamsChanged() {}
   };
 
   Parameters() {
     mSelectedParams = &global; // Init to using global params
+    for (auto& n : note.notes) {
+      n->parent = &global;
+      global.children.push_back(n.get());
+    }
   }
 
   // The 3 types of parameter sets
   ParamUI ui;
   ParamGlobal global;
   ParamsNote note;
+  // Per note state of the global LFOs and envelopes
+  VoiceModSources voiceMods{global.modLFOs, global.modEnvs};
+
+  // Creates all parameters and gives the host facing ones to the processor
+  void addParams(juce::AudioProcessor& p);
+  const juce::Array<juce::RangedAudioParameter*>& getAllParams() const { return mRegistry.getAll(); }
+  bool isCompactHost() const { return mRegistry.isCompact(); }
+  ParamRegistry& getRegistry() { return mRegistry; }
+  // Stable index used to key modulations, use instead of getParameterIndex() as it is -1 for internal parameters
+  int getParamIndex(const juce::AudioProcessorParameter* param) const { return mRegistry.getIndex(param); }
 
   void resetParams() {
     global.resetParams();
     note.resetParams();
   }
+  // Writes the saved values (defaults for any missing) straight into the parameters without per parameter notifications,
+  // then rebuilds the isUsed flags in one pass. Afterwards the host is told once and the listeners get paramsRestored()
+  void restoreParams(const juce::XmlElement* audioParams);
+
+  // Undo/redo of the parameter edits made from the UI, message thread only
+  // Changes whenever any parameter value changes, from any thread
+  juce::uint32 getParamsVersion() const { return mJournal.getVersion(); }
+  bool canUndo() const { return mJournal.canUndo(); }
+  bool canRedo() const { return mJournal.canRedo(); }
+  bool undo();
+  bool redo();
 
   juce::HashMap<int, Modulation> modulations;
 
@@ -741,7 +1010,8 @@ public:
   // Modulation processing
   void prepareModSources(int blockSize, double sampleRate);
   void processModSources();
-  void applyModulations(juce::RangedAudioParameter* param, float& value0To1);
+  // voice is the VoiceModSources slot of the note being rendered, -1 to only use the global mod sources
+  void applyModulations(juce::RangedAudioParameter* param, float& value0To1, int voice = -1);
   juce::XmlElement* getModulationsXml() {
     // Make Xml list of modulations to save in state
     juce::XmlElement* modXml = new juce::XmlElement("ParamModulations");
@@ -789,11 +1059,11 @@ public:
 
   // Finds the lowest level parameter that's different from its parent
   // Hierarchy (high to low): global, note, generator
-  // Optionally applies modulations before returning value
-  float getFloatParam(ParamCommon* common, ParamCommon::Type type, bool withModulations = false);
-  float getFloatParam(juce::AudioParameterFloat* param, bool withModulations = false);
-  int getIntParam(ParamCommon* common, ParamCommon::Type type, bool withModulations = false);
-  int getIntParam(juce::AudioParameterInt* param, bool withModulations = false);
+  // Optionally applies modulations (for the given voice) before returning value
+  float getFloatParam(ParamCommon* common, ParamCommon::Type type, bool withModulations = false, int voice = -1);
+  float getFloatParam(juce::AudioParameterFloat* param, bool withModulations = false, int voice = -1);
+  int getIntParam(ParamCommon* common, ParamCommon::Type type, bool withModulations = false, int voice = -1);
+  int getIntParam(juce::AudioParameterInt* param, bool withModulations = false, int voice = -1);
   int getChoiceParam(ParamCommon* common, ParamCommon::Type type);
   bool getBoolParam(ParamCommon* common, ParamCommon::Type type);
 
@@ -805,4 +1075,20 @@ private:
 
   // Listener list for our callbacks
   juce::ListenerList<Listener> mListeners;
+
+  ParamRegistry mRegistry;
+
+  // Which common param (if any) each param index is, to only update what a journaled change affects
+  struct ParamRef {
+    ParamCommon* owner = nullptr;
+    ParamCommon::Type type = ParamCommon::Type::NUM_COMMON;
+  };
+  std::vector<ParamRef> mParamRefs;
+  ParamJournal mJournal;
+
+  void handleAsyncUpdate() override;
+  // Drains the journal
+  void timerCallback() override;
+  void resyncJournal();
+  void applyJournalChange(const ParamJournal::Change& change, bool isUndo);
 };
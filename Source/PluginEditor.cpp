@@ -33,7 +33,7 @@ mSynth(synth),
 mParameters(synth.getParams()),
 mArcSpec(synth.getParams()),
 mTrimSelection(synth.getFormatManager(), synth.getParamUI()),
-mProgressBar(PROGRESS_VALUE),
+mProgressBar(mProgressValue),
 mTabsGrains(juce::TabbedButtonBar::Orientation::TabsAtTop),
 mTabsLFOs(juce::TabbedButtonBar::Orientation::TabsAtTop),
 mTabsEnvs(juce::TabbedButtonBar::Orientation::TabsAtTop),
@@ -116,19 +116,29 @@ mPianoPanel(synth.getKeyboardState(), synth.getParams()) {
     if (range.getLength() == 0.0) {
       displayError("Attempted to select an empty range");
     } else {
-      mSynth.trimAndExtractPitches(range);
-      // Reset any UI elements that will need to wait until processing
-      mArcSpec.reset();
-      mTitlePresetPanel.btnSavePreset.setEnabled(false);
+      // Only the selection is decoded, the progress bar shows over the arc spec until it's swapped in
       updateCenterComponent(ParamUI::CenterComponent::ARC_SPEC);
-      mArcSpec.loadWaveformBuffer(&mSynth.getAudioBuffer());
-      mParameters.ui.loadedFileName = mParameters.ui.fileName;
+      SafePointer<GRainbowAudioProcessorEditor> safeThis(this);
+      mSynth.trimAndExtractPitches(range, [safeThis](Utils::Result r) {
+        if (safeThis == nullptr) return;
+        if (r.success) {
+          // Reset any UI elements that will need to wait until processing
+          safeThis->mArcSpec.reset();
+          safeThis->mTitlePresetPanel.btnSavePreset.setEnabled(false);
+          safeThis->mArcSpec.loadWaveformBuffer(safeThis->mSynth.getAudioView());
+          safeThis->mParameters.ui.loadedFileName = safeThis->mParameters.ui.fileName;
+        } else {
+          safeThis->mParameters.ui.fileName = safeThis->mParameters.ui.loadedFileName;
+          safeThis->displayError(r.message);
+        }
+      });
     }
   };
 
   addAndMakeVisible(mPianoPanel);
 
   // These share the same space, but only 1 is seen at a time
+  mArcSpec.onNoteDetectionChanged = [this]() { mSynth.updateTranscription(); };
   addChildComponent(mArcSpec);
   mProgressBar.setColour(juce::ProgressBar::ColourIds::foregroundColourId, juce::Colours::blue.withSaturation(0.55f));
   mProgressBar.setColour(juce::ProgressBar::ColourIds::backgroundColourId, juce::Colours::whitesmoke);
@@ -154,7 +164,7 @@ mPianoPanel(synth.getKeyboardState(), synth.getParams()) {
     setWantsKeyboardFocus(true);
   }
 
-  mPianoPanel.waveform.load(mSynth.getAudioBuffer());
+  mPianoPanel.waveform.load(mSynth.getAudioView());
 
   mTooltipWindow->setMillisecondsBeforeTipAppears(500);  // default is 700ms
 
@@ -197,13 +207,24 @@ void GRainbowAudioProcessorEditor::updateCenterComponent(ParamUI::CenterComponen
 void GRainbowAudioProcessorEditor::timerCallback() {
   // Update progress bar when loading audio clip
   // Will overlay on the other center components
-  if (mParameters.ui.isLoading) {
+  if (mSynth.isFileLoading()) {
+    mProgressValue = mSynth.getLoadProgress();
+    mProgressBar.setVisible(true);
+  } else if (mParameters.ui.isLoading) {
+    mProgressValue = mSynth.getAnalysisProgress();
     mProgressBar.setVisible(true);
   } else if (mProgressBar.isVisible()) {
-    mPianoPanel.waveform.load(mSynth.getAudioBuffer());
+    mPianoPanel.waveform.load(mSynth.getAudioView());
     mProgressBar.setVisible(false);
   }
 
+  if (mSynth.takeHostLayoutMissing()) {
+    displayError(
+        "This session was saved with every parameter given to the host, but \"Compact host params\" is on in the settings. "
+        "Host automation of note and generator parameters in it is not played. Turn the setting off and reload the "
+        "plugin to play it, or move that automation to the host slots.");
+  }
+
   // Check for buffers needing to be updated
   if (!mParameters.ui.specComplete) {
     std::vector<Utils::SpecBuffer*> specs = mSynth.getProcessedSpecs();
@@ -212,6 +233,11 @@ void GRainbowAudioProcessorEditor::timerCallback() {
         mArcSpec.loadSpecBuffer(specs[i], (ParamUI::SpecType)i);
       }
     }
+  } else if (mSynth.getTranscriptionVersion() != mTranscriptionVersion) {
+    // Notes were made again, redraw the detected pitches from them
+    mTranscriptionVersion = mSynth.getTranscriptionVersion();
+    mArcSpec.reloadSpecBuffer(mSynth.getProcessedSpecs()[ParamUI::SpecType::DETECTED], ParamUI::SpecType::DETECTED,
+                              [this]() { mSynth.publishPitchSpec(); });
   } else if (mParameters.ui.isLoading) {
     // Spec complete, we're done loading
     mArcSpec.setSpecType(ParamUI::SpecType::HPCP);
@@ -341,6 +367,25 @@ void GRainbowAudioProcessorEditor::resized() {
   mProgressBar.setBounds(mArcSpec.getBounds().withSizeKeepingCentre(PROGRESS_SIZE, PROGRESS_SIZE));
 }
 
+bool GRainbowAudioProcessorEditor::keyPressed(const juce::KeyPress& key) {
+  // Cmd/Ctrl+Z to undo, with Shift to redo
+  if (key == juce::KeyPress('z', juce::ModifierKeys::commandModifier, 0)) {
+    mParameters.undo();
+    return true;
+  }
+  if (key == juce::KeyPress('z', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0)) {
+    mParameters.redo();
+    return true;
+  }
+  // Escape cancels a file still loading, what was loaded before stays
+  if (key == juce::KeyPress::escapeKey && mSynth.isFileLoading()) {
+    mSynth.cancelLoad();
+    mParameters.ui.fileName = mParameters.ui.loadedFileName;
+    return true;
+  }
+  return false;
+}
+
 bool GRainbowAudioProcessorEditor::isInterestedInFileDrag(const juce::StringArray& files) {
   // Only accept 1 file of wav/mp3/gbow at a time
   if (files.size() == 1) {
@@ -435,37 +480,42 @@ void GRainbowAudioProcessorEditor::openNewFile(const char* path) {
 //}
 
 void GRainbowAudioProcessorEditor::loadFile(juce::File file) {
-
+  // Decoding happens in the background, the UI is updated once the synth has swapped in what was loaded
+  SafePointer<GRainbowAudioProcessorEditor> safeThis(this);
   if (file.getFileExtension() == ".gbow") {
-    Utils::Result res = mSynth.loadPreset(file);
-    if (res.success) {
-      mTitlePresetPanel.btnSavePreset.setEnabled(true);
-      mArcSpec.loadPreset();
-      updateCenterComponent(ParamUI::CenterComponent::ARC_SPEC);
-      mPianoPanel.waveform.load(mSynth.getAudioBuffer());
-      mTitlePresetPanel.labelFileName.setText(mParameters.ui.loadedFileName, juce::sendNotificationAsync);
-      resized();
-    } else {
-      displayError(res.message);
-    }
+    mSynth.loadPresetAsync(file, [safeThis](Utils::Result res) {
+      if (safeThis == nullptr) return;
+      if (res.success) {
+        safeThis->mTitlePresetPanel.btnSavePreset.setEnabled(true);
+        safeThis->mArcSpec.loadPreset();
+        safeThis->updateCenterComponent(ParamUI::CenterComponent::ARC_SPEC);
+        safeThis->mPianoPanel.waveform.load(safeThis->mSynth.getAudioView());
+        safeThis->mTitlePresetPanel.labelFileName.setText(safeThis->mParameters.ui.loadedFileName, juce::sendNotificationAsync);
+        safeThis->resized();
+      } else {
+        safeThis->displayError(res.message);
+      }
+    });
   } else {
-    Utils::Result r = mSynth.loadAudioFile(file);
-    if (r.success) {
-      // Show users which file is being loaded/processed
-      mParameters.ui.fileName = file.getFullPathName();
-      mTitlePresetPanel.labelFileName.setText(mParameters.ui.fileName, juce::dontSendNotification);
-      mTrimSelection.parse(mSynth.getInputBuffer(), mSynth.getSampleRate(), mErrorMessage);
-      if (mErrorMessage.isEmpty()) {
-        // display screen to trim sample
-        updateCenterComponent(ParamUI::CenterComponent::TRIM_SELECTION);
+    mSynth.loadAudioFileAsync(file, [safeThis, file](Utils::Result r) {
+      if (safeThis == nullptr) return;
+      if (r.success) {
+        // Show users which file is being loaded/processed
+        safeThis->mParameters.ui.fileName = file.getFullPathName();
+        safeThis->mTitlePresetPanel.labelFileName.setText(safeThis->mParameters.ui.fileName, juce::dontSendNotification);
+        safeThis->mTrimSelection.parse(safeThis->mSynth.getInputFile(), safeThis->mSynth.getInputLengthSeconds(),
+                                       safeThis->mSynth.getSampleRate(), safeThis->mErrorMessage);
+        if (safeThis->mErrorMessage.isEmpty()) {
+          // display screen to trim sample
+          safeThis->updateCenterComponent(ParamUI::CenterComponent::TRIM_SELECTION);
+        } else {
+          safeThis->displayError(safeThis->mErrorMessage);
+          safeThis->mErrorMessage.clear();
+        }
       } else {
-        displayError(mErrorMessage);
-        mErrorMessage.clear();
-        return;
+        safeThis->displayError(r.message);
       }
-    } else {
-      displayError(r.message);
-    }
+    });
   }
 }
 
@@ -44,6 +44,7 @@ juce::Timer {
   void paint(juce::Graphics&) override;
   void paintOverChildren(juce::Graphics& g) override;
   void resized() override;
+  bool keyPressed(const juce::KeyPress& key) override;
 
   bool isInterestedInFileDrag(const juce::StringArray& files) override;
   void fileDragEnter(const juce::StringArray& files, int x, int y) override;
@@ -72,7 +73,7 @@ juce::Timer {
   ArcSpectrogram mArcSpec;
   TrimSelection mTrimSelection;
   juce::ProgressBar mProgressBar;
-  double PROGRESS_VALUE = -1.0; // Makes indeterminate spinning, shouldn't change
+  double mProgressValue = -1.0; // 0-1 while a file loads or is analyzed, -1 spins
 
   // UI Components
   TitlePresetPanel mTitlePresetPanel;
@@ -91,6 +92,7 @@ juce::Timer {
   juce::File mRecordedFile;
   juce::AudioDeviceManager mAudioDeviceManager;
   bool mIsFileHovering = false;
+  juce::uint32 mTranscriptionVersion = 0;  // Of the notes the detected pitches image was drawn from
   RainbowLookAndFeel mRainbowLookAndFeel;
   juce::Path mBorderPath;
 
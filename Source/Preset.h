@@ -10,6 +10,10 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
 // All information about the preset file layout. Done in seperate file for
 // future when possible different versions have different file structures and
 // want a single location to document it all.
@@ -25,9 +29,17 @@ const uint32_t MAGIC = 0x67626f77;
 //   VERSION_MAJOR++;
 //   VERSION_MINOR = 0;
 // }
-const uint32_t VERSION_MAJOR = 0;
+const uint32_t VERSION_MAJOR = 1;
 const uint32_t VERSION_MINOR = 0;
 
+// The first 3 fields are the same in every version
+struct VersionHeader {
+  uint32_t magic;
+  uint32_t versionMajor;
+  uint32_t versionMinor;
+};
+
+// Version 0.x header
 struct Header {
   uint32_t magic;
   uint32_t versionMajor;
@@ -56,4 +68,121 @@ struct Header {
 // - List of UI spec images as png blob (DEPRECATED - new files won't have anything here)
 // - XML of user param (binary form)
 
+// Version 1.x
+// -----------
+// Everything is in typed chunks listed in a table of contents so a loader can find (or skip) what it needs without
+// reading the rest. Readers must ignore chunk types they don't know, that is how minor versions add data.
+struct HeaderV1 {
+  uint32_t magic;
+  uint32_t versionMajor;
+  uint32_t versionMinor;
+  uint32_t numChunks;  // ChunkInfo entries right after the header
+  uint32_t reserved[8];
+};
+
+enum ChunkType : uint32_t {
+  CHUNK_AUDIO = 0,     // AudioChunk + samples
+  CHUNK_ANALYSIS = 1,  // Optional, AnalysisChunk + pitch detection results
+  CHUNK_IMAGES = 2,    // ImagesChunk + pixels of each spec image
+  CHUNK_PARAMS = 3,    // XML of user param (binary form), same as the version 0 XML without the images
+};
+
+struct ChunkInfo {
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t offset;  // From the start of the file, aligned to CHUNK_ALIGNMENT
+  uint64_t size;    // Bytes
+};
+const uint64_t CHUNK_ALIGNMENT = 16;
+
+enum AudioEncoding : uint32_t {
+  AUDIO_FLOAT32 = 0,         // Channels one after the other, native float
+  AUDIO_FLOAT32_PACKED = 1,  // Lossless Utils::AudioCodec blocks
+  AUDIO_INT16 = 2,           // zlib compressed mono int16 samples, times scale as float (Utils::SampleBuffer)
+};
+
+struct AudioChunk {
+  double sampleRate;
+  int32_t numSamples;
+  int32_t numChannels;
+  uint32_t encoding;  // AudioEncoding
+  float scale;        // AUDIO_INT16 only
+  uint32_t reserved[2];
+};
+
+struct ImagesChunk {
+  uint32_t numImages;
+  uint32_t reserved[3];
+};
+
+// Everything after the ImagesChunk is zlib compressed, each image is an ImageInfo followed by width * height 32 bit pixels,
+// premultiplied ARGB in native byte order (same as juce::Image::ARGB), rows top to bottom with no padding
+struct ImageInfo {
+  uint32_t specType;  // ParamUI::SpecType
+  int32_t width;
+  int32_t height;
+  uint32_t reserved;
+};
+
+// Only saved once the analysis of the audio finished. Everything after this header is zlib compressed:
+// - onsets, notes and contours posteriorgrams, numFrames rows of NUM_FREQ_OUT/NUM_FREQ_OUT/NUM_FREQ_IN IEEE half floats in
+//   native byte order
+// - numEvents times EventInfo followed by numBends int16 pitch bends
+// - numSpecs times SpecInfo followed by numFrames rows of numBins uint8 (0-255 is 0-maxValue)
+struct AnalysisChunk {
+  uint32_t numFrames;
+  uint32_t numEvents;
+  uint32_t numSpecs;
+  // The note detection (ParamUI) the events were made with
+  float noteSensitivity;
+  float splitSensitivity;
+  float minNoteLengthMs;
+  uint32_t reserved[2];
+};
+
+struct EventInfo {
+  double startTime;
+  double endTime;
+  double amplitude;
+  int32_t startFrame;
+  int32_t endFrame;
+  int32_t pitch;
+  int32_t numBends;
+};
+
+struct SpecInfo {
+  uint32_t specType;  // ParamUI::SpecType
+  uint32_t numFrames;
+  uint32_t numBins;
+  float maxValue;
+};
+
+// Version 1.0 layout
+// ------------------
+// - HeaderV1
+// - ChunkInfo[numChunks]
+// - Chunks (each at its ChunkInfo offset)
+
+// Reads the table of contents of a version 1 file, false if it doesn't fit in the data
+inline bool readChunks(const void* data, size_t size, std::vector<ChunkInfo>& chunks) {
+  if (size < sizeof(HeaderV1)) return false;
+  HeaderV1 header;
+  std::memcpy(&header, data, sizeof(header));
+  if (header.numChunks > (size - sizeof(HeaderV1)) / sizeof(ChunkInfo)) return false;
+  chunks.resize(header.numChunks);
+  std::memcpy(chunks.data(), static_cast<const uint8_t*>(data) + sizeof(HeaderV1), header.numChunks * sizeof(ChunkInfo));
+  for (const ChunkInfo& chunk : chunks) {
+    if (chunk.offset > size || chunk.size > size - chunk.offset) return false;
+  }
+  return true;
+}
+
+// Returns nullptr if there is no chunk of the type
+inline const ChunkInfo* findChunk(const std::vector<ChunkInfo>& chunks, uint32_t type) {
+  for (const ChunkInfo& chunk : chunks) {
+    if (chunk.type == type) return &chunk;
+  }
+  return nullptr;
+}
+
 }  // namespace Preset
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    AudioCodec.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstring>
+
+namespace Utils {
+
+/**
+ * Lossless codec for the float audio saved in presets (FLAC tops out at 24 bit ints, so it isn't lossless for our buffers).
+ * Each block of BLOCK_SAMPLES of a channel is coded on its own: the float bit patterns are delta coded against the previous
+ * sample, split into byte planes (all the low bytes, then the next, ...) so the slow moving high bytes sit together, then
+ * zlib compressed. Blocks don't depend on each other so they can be decoded in any order or on any thread.
+ *
+ * Layout: uint32 blockSamples, uint32 numBlocks, uint32 compressedSize[numBlocks], then the blocks, channel after channel
+ */
+namespace AudioCodec {
+
+static constexpr int BLOCK_SAMPLES = 1 << 16;
+static constexpr int COMPRESSION_LEVEL = 3;  // Higher levels barely shrink the residuals and make state saves slower
+
+[[maybe_unused]] static void encodeBlock(const float* samples, int numSamples, juce::MemoryBlock& dest) {
+  juce::HeapBlock<uint8_t> planes((size_t)numSamples * sizeof(float));
+  uint32_t prev = 0;
+  for (int i = 0; i < numSamples; ++i) {
+    uint32_t bits;
+    std::memcpy(&bits, samples + i, sizeof(bits));
+    const uint32_t delta = bits - prev;
+    prev = bits;
+    for (int b = 0; b < 4; ++b) {
+      planes[(size_t)b * numSamples + i] = (uint8_t)(delta >> (8 * b));
+    }
+  }
+  juce::MemoryOutputStream out(dest, false);
+  juce::GZIPCompressorOutputStream zip(out, COMPRESSION_LEVEL);
+  zip.write(planes.get(), (size_t)numSamples * sizeof(float));
+  zip.flush();
+}
+
+[[maybe_unused]] static bool decodeBlock(const void* data, size_t size, float* samples, int numSamples) {
+  juce::MemoryInputStream in(data, size, false);
+  juce::GZIPDecompressorInputStream unzip(in);
+  const int planesSize = numSamples * (int)sizeof(float);
+  juce::HeapBlock<uint8_t> planes((size_t)planesSize);
+  int numRead = 0;
+  while (numRead < planesSize) {
+    const int n = unzip.read(planes.get() + numRead, planesSize - numRead);
+    if (n <= 0) return false;
+    numRead += n;
+  }
+  uint32_t prev = 0;
+  for (int i = 0; i < numSamples; ++i) {
+    const uint32_t delta = (uint32_t)planes[i] | ((uint32_t)planes[numSamples + i] << 8) |
+                           ((uint32_t)planes[2 * numSamples + i] << 16) | ((uint32_t)planes[3 * numSamples + i] << 24);
+    prev += delta;
+    std::memcpy(samples + i, &prev, sizeof(prev));
+  }
+  return true;
+}
+
+[[maybe_unused]] static void encode(const juce::AudioBuffer<float>& buffer, juce::OutputStream& out) {
+  const int blocksPerChannel = (buffer.getNumSamples() + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES;
+  std::vector<juce::MemoryBlock> blocks((size_t)(blocksPerChannel * buffer.getNumChannels()));
+  for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+    for (int b = 0; b < blocksPerChannel; ++b) {
+      const int start = b * BLOCK_SAMPLES;
+      encodeBlock(buffer.getReadPointer(ch, start), juce::jmin(BLOCK_SAMPLES, buffer.getNumSamples() - start),
+                  blocks[(size_t)(ch * blocksPerChannel + b)]);
+    }
+  }
+  out.writeInt(BLOCK_SAMPLES);
+  out.writeInt((int)blocks.size());
+  for (auto& block : blocks) out.writeInt((int)block.getSize());
+  for (auto& block : blocks) out.write(block.getData(), block.getSize());
+}
+
+// The buffer has to already be the size of what was encoded
+[[maybe_unused]] static bool decode(const void* data, size_t size, juce::AudioBuffer<float>& buffer) {
+  juce::MemoryInputStream in(data, size, false);
+  const int blockSamples = in.readInt();
+  const int numBlocks = in.readInt();
+  if (blockSamples <= 0) return buffer.getNumSamples() == 0;
+  // encode() always uses BLOCK_SAMPLES, the block count has to match the buffer the caller sized from its own header
+  if (blockSamples != BLOCK_SAMPLES) return false;
+  const juce::int64 blocksPerChannel = (buffer.getNumSamples() + (juce::int64)blockSamples - 1) / blockSamples;
+  if ((juce::int64)numBlocks != blocksPerChannel * buffer.getNumChannels() ||
+      in.getNumBytesRemaining() < (juce::int64)numBlocks * 4) {
+    return false;
+  }
+  std::vector<size_t> blockSizes((size_t)numBlocks);
+  for (auto& blockSize : blockSizes) blockSize = (size_t)(juce::uint32)in.readInt();
+
+  size_t offset = (size_t)in.getPosition();
+  for (int i = 0; i < numBlocks; ++i) {
+    if (blockSizes[(size_t)i] > size - offset) return false;
+    const int ch = (int)(i / blocksPerChannel);
+    const int start = (int)(i % blocksPerChannel) * blockSamples;
+    if (!decodeBlock(static_cast<const uint8_t*>(data) + offset, blockSizes[(size_t)i], buffer.getWritePointer(ch, start),
+                     juce::jmin(blockSamples, buffer.getNumSamples() - start))) {
+      return false;
+    }
+    offset += blockSizes[(size_t)i];
+  }
+  return true;
+}
+
+}  // namespace AudioCodec
+}  // namespace Utils
@@ -1,30 +1,91 @@
 #pragma once
 
 #include "juce_audio_basics/juce_audio_basics.h"
+#include <cstring>
+#include <functional>
+#include "Matrix.h"
+#include "Resampler.h"
 
 namespace Utils {
 
-// 2D vector container for spectra
-typedef std::vector<std::vector<float>> SpecBuffer;
+// Frames x bins container for spectra
+typedef Matrix<float> SpecBuffer;
 
 // Audio buffer processing
-static void resampleAudioBuffer(juce::AudioBuffer<float>& inputBuffer, juce::AudioBuffer<float>& outputBuffer,
-                                        double inputSampleRate, double outputSampleRate, bool clearInput = false) {
+// Number of samples resampleAudioBuffer() makes out of numSamples
+static int getResampledSize(int numSamples, double inputSampleRate, double outputSampleRate) {
+  return static_cast<int>(static_cast<double>(numSamples) * (outputSampleRate / inputSampleRate));
+}
+
+// The optional progress is called with 0-1 along the way, returning false stops the resampling and it returns false
+static bool resampleAudioBuffer(juce::AudioBuffer<float>& inputBuffer, juce::AudioBuffer<float>& outputBuffer,
+                                        double inputSampleRate, double outputSampleRate, bool clearInput = false,
+                                        const std::function<bool(float)>& progress = nullptr) {
+  static constexpr int PROGRESS_BLOCK_SAMPLES = 1 << 16;
   const double ratioToInput = inputSampleRate / outputSampleRate;   // input / output
-  const double ratioToOutput = outputSampleRate / inputSampleRate;  // output / input
-  // The output buffer needs to be size that matches the new sample rate
-  const int resampleSize = static_cast<int>(static_cast<double>(inputBuffer.getNumSamples()) * ratioToOutput);
+  // The output buffer needs to be size that matches the new sample rate, if it already is it's written in place
+  const int resampleSize = getResampledSize(inputBuffer.getNumSamples(), inputSampleRate, outputSampleRate);
   outputBuffer.setSize(inputBuffer.getNumChannels(), resampleSize);
 
   const float* const* inputs = inputBuffer.getArrayOfReadPointers();
   float* const* outputs = outputBuffer.getArrayOfWritePointers();
+  const float totalSamples = static_cast<float>(outputBuffer.getNumChannels()) * static_cast<float>(resampleSize);
+
+  if (auto polyphase = PolyphaseResampler::get(inputSampleRate, outputSampleRate)) {
+    // No state between blocks, each one is made in parallel segments and progress stays on this thread
+    juce::SharedResourcePointer<SharedThreadPool> pool;
+    for (int c = 0; c < outputBuffer.getNumChannels(); c++) {
+      for (int start = 0; start < resampleSize; start += PROGRESS_BLOCK_SAMPLES) {
+        const int numSamples = juce::jmin(PROGRESS_BLOCK_SAMPLES, resampleSize - start);
+        polyphase->process(pool->pool, inputs[c], inputBuffer.getNumSamples(), outputs[c] + start, start, numSamples);
+        if (progress && !progress((static_cast<float>(c) * resampleSize + start + numSamples) / totalSamples)) return false;
+      }
+    }
+    if (clearInput) inputBuffer.setSize(1, 1);
+    return true;
+  }
 
+  // Rates without a polyphase filter bank (fractional, or an odd ratio)
   std::unique_ptr<juce::LagrangeInterpolator> resampler = std::make_unique<juce::LagrangeInterpolator>();
   for (int c = 0; c < outputBuffer.getNumChannels(); c++) {
     resampler->reset();
-    resampler->process(ratioToInput, inputs[c], outputs[c], outputBuffer.getNumSamples());
+    // The interpolator keeps its state between calls, so going in blocks gives the same output as all at once
+    const float* input = inputs[c];
+    for (int start = 0; start < resampleSize; start += PROGRESS_BLOCK_SAMPLES) {
+      const int numSamples = juce::jmin(PROGRESS_BLOCK_SAMPLES, resampleSize - start);
+      input += resampler->process(ratioToInput, input, outputs[c] + start, numSamples);
+      if (progress && !progress((static_cast<float>(c) * resampleSize + start + numSamples) / totalSamples)) return false;
+    }
   }
   if (clearInput) inputBuffer.setSize(1, 1);
+  return true;
+}
+
+// Resamples a single channel a block at a time, consume(samples, numSamples) is called with each block as it's made and
+// returns false to stop early (then this returns false too). Same samples as resampleAudioBuffer() makes
+static bool resampleAudioStream(const float* input, int numSamples, double inputSampleRate, double outputSampleRate,
+                                const std::function<bool(const float*, int)>& consume) {
+  static constexpr int BLOCK_SAMPLES = 1 << 14;
+  const double ratioToInput = inputSampleRate / outputSampleRate;
+  const int resampleSize = getResampledSize(numSamples, inputSampleRate, outputSampleRate);
+  std::vector<float> block((size_t)BLOCK_SAMPLES);
+  if (auto polyphase = PolyphaseResampler::get(inputSampleRate, outputSampleRate)) {
+    juce::SharedResourcePointer<SharedThreadPool> pool;
+    for (int start = 0; start < resampleSize; start += BLOCK_SAMPLES) {
+      const int blockSize = juce::jmin(BLOCK_SAMPLES, resampleSize - start);
+      polyphase->process(pool->pool, input, numSamples, block.data(), start, blockSize);
+      if (!consume(block.data(), blockSize)) return false;
+    }
+    return true;
+  }
+
+  juce::LagrangeInterpolator resampler;
+  for (int start = 0; start < resampleSize; start += BLOCK_SAMPLES) {
+    const int blockSize = juce::jmin(BLOCK_SAMPLES, resampleSize - start);
+    input += resampler.process(ratioToInput, input, block.data(), blockSize);
+    if (!consume(block.data(), blockSize)) return false;
+  }
+  return true;
 }
 
 static void trimAudioBuffer(juce::AudioBuffer<float>& inputBuffer, juce::AudioBuffer<float>& outputBuffer,
@@ -43,6 +104,79 @@ static void trimAudioBuffer(juce::AudioBuffer<float>& inputBuffer, juce::AudioBu
   if (clearInput) inputBuffer.setSize(1, 1);
 }
 
+// 64 bit FNV-1a of the sample bits, to tell if audio was seen before without keeping it around
+static uint64_t hashAudioBuffer(const juce::AudioBuffer<float>& buffer) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  auto mix = [&hash](uint32_t value) {
+    hash ^= value;
+    hash *= 0x100000001b3ull;
+  };
+  mix((uint32_t)buffer.getNumChannels());
+  mix((uint32_t)buffer.getNumSamples());
+  for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+    const float* samples = buffer.getReadPointer(ch);
+    for (int i = 0; i < buffer.getNumSamples(); ++i) {
+      uint32_t bits;
+      std::memcpy(&bits, samples + i, sizeof(bits));
+      mix(bits);
+    }
+  }
+  return hash;
+}
 
+// IEEE half precision, rounded to nearest even like a hardware conversion
+static uint16_t floatToHalf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint32_t sign = (bits >> 16) & 0x8000;
+  const int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+  if (((bits >> 23) & 0xff) == 0xff) return (uint16_t)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));  // Inf, NaN
+  if (exponent >= 31) return (uint16_t)(sign | 0x7c00);  // Too large, inf
+  uint32_t half;
+  uint32_t rest;
+  uint32_t halfway;
+  if (exponent <= 0) {
+    // Subnormal, or zero when it's too small for that too
+    if (exponent < -10) return (uint16_t)sign;
+    mantissa |= 0x800000;
+    const int shift = 14 - exponent;
+    half = mantissa >> shift;
+    rest = mantissa & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+  } else {
+    half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    rest = mantissa & 0x1fff;
+    halfway = 0x1000;
+  }
+  // A carry into the exponent is still the right value
+  if (rest > halfway || (rest == halfway && (half & 1))) half++;
+  return (uint16_t)(sign | half);
+}
+
+static float halfToFloat(uint16_t half) {
+  const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // Subnormal, normalized for the float exponent
+    int shift = 0;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      shift++;
+    }
+    bits = sign | ((uint32_t)(127 - 14 - shift) << 23) | ((mantissa & 0x3ff) << 13);
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
 
 }  // namespace Utils
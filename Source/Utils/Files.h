@@ -11,13 +11,21 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
+#include <algorithm>
 
 namespace Utils {
 
 // Paths for bookkeeping files
 static const juce::File FILE_DATA_BASE = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userApplicationDataDirectory).getChildFile("StrangeLoops").getChildFile("gRainbow");
 static const juce::File FILE_RECENT_FILES = FILE_DATA_BASE.getChildFile("_recentFiles.json");
+static const juce::File FILE_HOST_PARAMS = FILE_DATA_BASE.getChildFile("_hostParams.json");
+static const juce::File FILE_SETTINGS = FILE_DATA_BASE.getChildFile("_settings.json");
 static constexpr int MAX_RECENT_FILES = 20;
+// Pitch analysis of audio already seen, keyed by a hash of the audio and the analysis settings
+static const juce::File FILE_ANALYSIS_CACHE = FILE_DATA_BASE.getChildFile("AnalysisCache");
+static constexpr juce::int64 MAX_ANALYSIS_CACHE_BYTES = 256 * 1024 * 1024;
+// Backing files of audio too long to keep in memory, only exist while the audio is in use
+static const juce::File FILE_STREAM_CACHE = FILE_DATA_BASE.getChildFile("StreamCache");
 
 static juce::var getRecentFiles() {
   // Save loaded file in recent files list
@@ -47,4 +55,75 @@ static void addRecentFile(juce::String newFile) {
   }
 }
 
+static juce::File getAnalysisCacheFile(const juce::String& key) { return FILE_ANALYSIS_CACHE.getChildFile(key + ".analysis"); }
+
+// The cache is least recently used first out, a hit has to mark the file as used
+static void touchAnalysisCacheFile(const juce::File& file) { file.setLastModificationTime(juce::Time::getCurrentTime()); }
+
+static void addAnalysisCacheFile(const juce::File& file, const void* data, size_t size) {
+  FILE_ANALYSIS_CACHE.createDirectory();
+  // Goes through a temporary file so another instance never reads a half written one
+  juce::TemporaryFile temp(file);
+  if (!temp.getFile().replaceWithData(data, size) || !temp.overwriteTargetFileWithTemporary()) return;
+
+  juce::Array<juce::File> files = FILE_ANALYSIS_CACHE.findChildFiles(juce::File::findFiles, false, "*.analysis");
+  std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b) {
+    return a.getLastModificationTime() > b.getLastModificationTime();
+  });
+  juce::int64 totalSize = 0;
+  for (const juce::File& cached : files) {
+    totalSize += cached.getSize();
+    if (totalSize > MAX_ANALYSIS_CACHE_BYTES) cached.deleteFile();
+  }
+}
+
+// Settings files are a single JSON object, missing or broken files read as an empty one
+static juce::var readSettingsFile(const juce::File& file) {
+  juce::FileInputStream input(file);
+  if (input.openedOk()) {
+    juce::var settings = juce::JSON::parse(input);
+    if (settings.isObject()) return settings;
+  }
+  return juce::var(new juce::DynamicObject());
+}
+
+static void writeSettingsFile(const juce::File& file, const juce::var& settings) {
+  juce::FileOutputStream output(file);
+  if (output.openedOk()) {
+    output.setPosition(0);
+    output.truncate();
+    juce::JSON::writeToStream(output, settings);
+  }
+}
+
+// Host parameter layout, read once when the plugin is created as hosts expect the parameter list to never change.
+// { "compact": bool }. Which parameters the host slots drive is saved with the session instead
+static bool getHostParamsCompact() { return static_cast<bool>(readSettingsFile(FILE_HOST_PARAMS)["compact"]); }
+
+static void setHostParamsCompact(bool compact) {
+  juce::var settings = readSettingsFile(FILE_HOST_PARAMS);
+  settings.getDynamicObject()->setProperty("compact", compact);
+  writeSettingsFile(FILE_HOST_PARAMS, settings);
+}
+
+// Keep the audio grains play from as 16 bit samples, applies to audio loaded after it's changed.
+// In _settings.json as { "compactAudio": bool }
+static bool getCompactAudio() { return static_cast<bool>(readSettingsFile(FILE_SETTINGS)["compactAudio"]); }
+
+static void setCompactAudio(bool compact) {
+  juce::var settings = readSettingsFile(FILE_SETTINGS);
+  settings.getDynamicObject()->setProperty("compactAudio", compact);
+  writeSettingsFile(FILE_SETTINGS, settings);
+}
+
+// Make the spectrogram and harmonic profile views from the CQT of the pitch detection instead of a separate FFT of the
+// audio, applies to audio analyzed after it's changed. In _settings.json as { "specsFromFeatures": bool }
+static bool getSpecsFromFeatures() { return static_cast<bool>(readSettingsFile(FILE_SETTINGS)["specsFromFeatures"]); }
+
+static void setSpecsFromFeatures(bool fromFeatures) {
+  juce::var settings = readSettingsFile(FILE_SETTINGS);
+  settings.getDynamicObject()->setProperty("specsFromFeatures", fromFeatures);
+  writeSettingsFile(FILE_SETTINGS, settings);
+}
+
 }  // namespace Utils
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    MappedAudioBuffer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "DSP.h"
+#include "Files.h"
+
+namespace Utils {
+
+/**
+ * Storage for audio too long to comfortably keep in memory. The samples live in a file that is memory mapped, so the OS only
+ * keeps the pages being used resident and can drop them again under memory pressure.
+ * A page that isn't resident would stall whatever reads it, the audio thread included. So windows about to be read are
+ * given as hints and a read-ahead thread (this is a TimeSliceClient) touches their pages before the grains get there.
+ */
+class MappedAudioBuffer : public juce::TimeSliceClient {
+ public:
+  static constexpr double MIN_SECONDS = 600.0;  // Anything shorter is kept in memory
+  static constexpr int MAX_HINTS = 256;         // Most recent windows kept read ahead
+  static constexpr int PAGE_SAMPLES = 4096 / sizeof(float);
+  static constexpr int READ_AHEAD_INTERVAL_MS = 50;
+
+  ~MappedAudioBuffer() override {
+    mMap.reset();
+    mFile.deleteFile();
+  }
+
+  // False if the file couldn't be made or mapped, the audio has to be kept in memory then
+  bool create(int numChannels, int numSamples) {
+    FILE_STREAM_CACHE.createDirectory();
+    mFile = FILE_STREAM_CACHE.getNonexistentChildFile("stream", ".raw", false);
+    const juce::int64 numBytes = (juce::int64)numChannels * numSamples * (juce::int64)sizeof(float);
+    {
+      // Sized by writing the last byte, the rest is left sparse and reads as zeros
+      juce::FileOutputStream out(mFile);
+      if (numBytes <= 0 || !out.openedOk() || !out.setPosition(numBytes - 1) || !out.writeByte(0)) {
+        mFile.deleteFile();
+        return false;
+      }
+    }
+    mMap = std::make_unique<juce::MemoryMappedFile>(mFile, juce::MemoryMappedFile::readWrite, false);
+    if (mMap->getData() == nullptr || (juce::int64)mMap->getSize() < numBytes) {
+      mMap.reset();
+      mFile.deleteFile();
+      return false;
+    }
+
+    mChannels.resize((size_t)numChannels);
+    for (int ch = 0; ch < numChannels; ++ch) {
+      mChannels[(size_t)ch] = static_cast<float*>(mMap->getData()) + (size_t)ch * numSamples;
+    }
+    mNumSamples = numSamples;
+    return true;
+  }
+
+  // The buffer only points at the mapping, it has to stop being used before this is destroyed
+  void referTo(juce::AudioBuffer<float>& buffer) {
+    buffer.setDataToReferTo(mChannels.data(), (int)mChannels.size(), mNumSamples);
+  }
+
+  // Audio thread, [start, start + numSamples) is about to be read. Lock-free, replaces the oldest hint
+  void addHint(int start, int numSamples) {
+    start = juce::jlimit(0, mNumSamples, start);
+    numSamples = juce::jlimit(0, mNumSamples - start, numSamples);
+    const juce::uint32 slot = mNextHint.fetch_add(1, std::memory_order_relaxed) % MAX_HINTS;
+    mHints[slot].store(((juce::int64)start << 32) | (juce::uint32)numSamples, std::memory_order_relaxed);
+  }
+
+  // Not the audio thread, windows to keep read ahead until they are replaced (ie the candidates)
+  void setPinnedHints(std::vector<juce::Range<int>> ranges) {
+    const juce::ScopedLock lock(mPinnedLock);
+    mPinnedHints = std::move(ranges);
+  }
+
+  int useTimeSlice() override {
+    for (const auto& hint : mHints) {
+      const juce::int64 value = hint.load(std::memory_order_relaxed);
+      touch((int)(value >> 32), (int)(value & 0xffffffff));
+    }
+    {
+      const juce::ScopedLock lock(mPinnedLock);
+      for (const juce::Range<int>& range : mPinnedHints) touch(range.getStart(), range.getLength());
+    }
+    return READ_AHEAD_INTERVAL_MS;
+  }
+
+ private:
+  // Reads a sample of every page so the OS faults them in (or keeps them as recently used)
+  void touch(int start, int numSamples) {
+    const int end = juce::jmin(mNumSamples, start + numSamples);
+    start = juce::jmax(0, start);
+    if (start >= end) return;
+    float sum = 0.0f;
+    for (float* channel : mChannels) {
+      for (int i = start; i < end; i += PAGE_SAMPLES) sum += channel[i];
+      sum += channel[end - 1];
+    }
+    mSink = sum;
+  }
+
+  juce::File mFile;
+  std::unique_ptr<juce::MemoryMappedFile> mMap;
+  std::vector<float*> mChannels;
+  int mNumSamples = 0;
+
+  std::array<std::atomic<juce::int64>, MAX_HINTS> mHints{};
+  std::atomic<juce::uint32> mNextHint{0};
+  juce::CriticalSection mPinnedLock;
+  std::vector<juce::Range<int>> mPinnedHints;
+  volatile float mSink = 0.0f;  // Keeps the touching reads from being optimized away
+};
+
+// Sizes buffer for numSamples at sampleRate, backed by a MappedAudioBuffer (left in mapping) when it's long enough to be
+// worth streaming from disk and in memory otherwise. Whatever buffer held before is dropped
+[[maybe_unused]] static void allocateAudioBuffer(juce::AudioBuffer<float>& buffer, std::unique_ptr<MappedAudioBuffer>& mapping,
+                                                 int numChannels, int numSamples, double sampleRate) {
+  // Let go of the old mapping first, otherwise setSize() could keep pointing into it
+  buffer.setSize(0, 0);
+  mapping.reset();
+  if (numSamples >= MappedAudioBuffer::MIN_SECONDS * sampleRate) {
+    auto newMapping = std::make_unique<MappedAudioBuffer>();
+    if (newMapping->create(numChannels, numSamples)) {
+      newMapping->referTo(buffer);
+      mapping = std::move(newMapping);
+      return;
+    }
+  }
+  buffer.setSize(numChannels, numSamples);
+}
+
+// resampleAudioBuffer() into storage from allocateAudioBuffer()
+[[maybe_unused]] static bool resampleAudioBuffer(juce::AudioBuffer<float>& inputBuffer, juce::AudioBuffer<float>& outputBuffer,
+                                                 std::unique_ptr<MappedAudioBuffer>& outputMapping, double inputSampleRate,
+                                                 double outputSampleRate, bool clearInput = false,
+                                                 const std::function<bool(float)>& progress = nullptr) {
+  allocateAudioBuffer(outputBuffer, outputMapping, inputBuffer.getNumChannels(),
+                      getResampledSize(inputBuffer.getNumSamples(), inputSampleRate, outputSampleRate), outputSampleRate);
+  return resampleAudioBuffer(inputBuffer, outputBuffer, inputSampleRate, outputSampleRate, clearInput, progress);
+}
+
+}  // namespace Utils
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    Matrix.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace Utils {
+
+/**
+ * Row-major 2D array in a single allocation, for frames x bins data like the posteriorgrams. Rows are padded so each one
+ * starts SIMD aligned, and m[row][col] works like it does on nested vectors.
+ * Adding rows keeps the contents and reserves ahead, so appending a window of frames at a time doesn't copy everything.
+ */
+template <typename T>
+class Matrix {
+  static_assert(std::is_trivially_copyable<T>::value, "Rows are copied with memcpy");
+
+ public:
+  static constexpr size_t ALIGNMENT = 32;
+
+  Matrix() = default;
+  Matrix(size_t numRows, size_t numCols) { resize(numRows, numCols); }
+  Matrix(const Matrix& other) { *this = other; }
+  Matrix(Matrix&& other) noexcept { swap(other); }
+
+  Matrix& operator=(const Matrix& other) {
+    if (this != &other) {
+      clear();
+      resize(other.mNumRows, other.mNumCols);
+      if (mNumRows > 0) std::memcpy(mData, other.mData, mNumRows * mStride * sizeof(T));
+    }
+    return *this;
+  }
+  Matrix& operator=(Matrix&& other) noexcept {
+    Matrix moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+
+  void swap(Matrix& other) noexcept {
+    mStorage.swapWith(other.mStorage);
+    std::swap(mData, other.mData);
+    std::swap(mNumRows, other.mNumRows);
+    std::swap(mNumCols, other.mNumCols);
+    std::swap(mStride, other.mStride);
+    std::swap(mCapacity, other.mCapacity);
+  }
+
+  // Added elements are zeroed. The contents are kept if the number of columns is the same, dropped otherwise
+  void resize(size_t numRows, size_t numCols) {
+    if (numCols != mNumCols) {
+      clear();
+      mNumCols = numCols;
+      const size_t perAlignment = std::max(size_t(1), ALIGNMENT / sizeof(T));
+      mStride = (numCols + perAlignment - 1) / perAlignment * perAlignment;
+    }
+    if (numRows > mCapacity) {
+      // Grows geometrically for callers appending a few rows at a time
+      reallocate(std::max(numRows, mCapacity + mCapacity / 2));
+    }
+    if (numRows > mNumRows && mStride > 0) {
+      std::memset(static_cast<void*>((*this)[mNumRows]), 0, (numRows - mNumRows) * mStride * sizeof(T));
+    }
+    mNumRows = numRows;
+  }
+
+  // Frees the memory as well
+  void clear() {
+    mStorage.free();
+    mData = nullptr;
+    mNumRows = 0;
+    mNumCols = 0;
+    mStride = 0;
+    mCapacity = 0;
+  }
+
+  void fill(T value) {
+    for (size_t row = 0; row < mNumRows; ++row) std::fill_n((*this)[row], mNumCols, value);
+  }
+
+  T* operator[](size_t row) { return mData + row * mStride; }
+  const T* operator[](size_t row) const { return mData + row * mStride; }
+
+  size_t getNumRows() const { return mNumRows; }
+  size_t getNumCols() const { return mNumCols; }
+  size_t getStride() const { return mStride; }
+  bool isEmpty() const { return mNumRows == 0; }
+
+ private:
+  void reallocate(size_t capacity) {
+    // HeapBlock isn't aligned beyond malloc's guarantee, over-allocate and align the start
+    juce::HeapBlock<char> storage(capacity * mStride * sizeof(T) + ALIGNMENT);
+    T* data = reinterpret_cast<T*>((reinterpret_cast<uintptr_t>(storage.get()) + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+    if (mNumRows > 0) std::memcpy(static_cast<void*>(data), mData, mNumRows * mStride * sizeof(T));
+    mStorage.swapWith(storage);
+    mData = data;
+    mCapacity = capacity;
+  }
+
+  juce::HeapBlock<char> mStorage;
+  T* mData = nullptr;
+  size_t mNumRows = 0;
+  size_t mNumCols = 0;
+  size_t mStride = 0;
+  size_t mCapacity = 0;  // Rows allocated
+};
+
+}  // namespace Utils
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    Resampler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <numeric>
+#include "Matrix.h"
+#include "TaskGraph.h"
+
+namespace Utils {
+
+/**
+ * Windowed-sinc polyphase resampler, for rates whose ratio reduces to output/input = up/down with at most MAX_PHASES
+ * phases, which covers every pair of the usual rates (44.1/48/88.2/96 kHz, 22.05 kHz for the pitch detection, ...).
+ * Each phase's filter is made once per rate pair and shared by everything resampling between those rates.
+ * An output sample only depends on the input around it, so any range of the output can be made on its own. Long
+ * buffers are made in segments in parallel.
+ */
+class PolyphaseResampler {
+ public:
+  static constexpr int MAX_PHASES = 1024;
+  static constexpr int ZERO_CROSSINGS = 16;  // Of the sinc on each side, at the lower of the two rates
+  static constexpr double ROLLOFF = 0.94;    // Cutoff as a part of the lower Nyquist, the transition band is above it
+  static constexpr double KAISER_BETA = 9.0;
+  static constexpr int TAP_ALIGNMENT = 8;  // Taps of a phase are padded to a multiple of this, for the dot product
+  static constexpr int SEGMENT_SAMPLES = 1 << 12;  // Output samples each parallel task makes
+
+  // Shared for each rate pair, nullptr if the rates aren't whole numbers or their ratio needs more than MAX_PHASES
+  static std::shared_ptr<const PolyphaseResampler> get(double inputSampleRate, double outputSampleRate) {
+    const juce::int64 inputRate = (juce::int64)inputSampleRate;
+    const juce::int64 outputRate = (juce::int64)outputSampleRate;
+    if (inputRate <= 0 || outputRate <= 0 || (double)inputRate != inputSampleRate || (double)outputRate != outputSampleRate) {
+      return nullptr;
+    }
+    const juce::int64 divisor = std::gcd(inputRate, outputRate);
+    const int up = (int)(outputRate / divisor);
+    const int down = (int)juce::jmin(inputRate / divisor, (juce::int64)std::numeric_limits<int>::max());
+    if (up > MAX_PHASES) return nullptr;
+
+    static juce::CriticalSection lock;
+    static std::map<std::pair<int, int>, std::shared_ptr<const PolyphaseResampler>> banks;
+    const juce::ScopedLock scopedLock(lock);
+    auto& bank = banks[{up, down}];
+    if (bank == nullptr) bank.reset(new PolyphaseResampler(up, down));
+    return bank;
+  }
+
+  // Output samples [start, start + numOutput) of resampling numInput samples of input, outside of it is silence
+  void process(const float* input, int numInput, float* output, juce::int64 start, int numOutput) const {
+    for (int n = 0; n < numOutput; ++n) {
+      // Where the output sample is in the input, as whole samples and the phase between two of them
+      const juce::int64 position = (start + n) * mDown;
+      const juce::int64 first = position / mUp - mCenter;
+      const float* taps = mPhases[(size_t)(position % mUp)];
+      if (first >= 0 && first + mNumTaps <= numInput) {
+        output[n] = dot(taps, input + first);
+      } else {
+        // Near the edges only the taps over the input count
+        float sum = 0.0f;
+        for (int k = (int)juce::jmax((juce::int64)0, -first); k < mNumTaps && first + k < numInput; ++k) {
+          sum += taps[k] * input[first + k];
+        }
+        output[n] = sum;
+      }
+    }
+  }
+
+  // process() split in segments made on the pool, the calling thread included
+  void process(juce::ThreadPool& pool, const float* input, int numInput, float* output, juce::int64 start,
+               int numOutput) const {
+    const int numSegments = (numOutput + SEGMENT_SAMPLES - 1) / SEGMENT_SAMPLES;
+    parallelFor(pool, numSegments, [&](int segment) {
+      const int offset = segment * SEGMENT_SAMPLES;
+      process(input, numInput, output + offset, start + offset, juce::jmin(SEGMENT_SAMPLES, numOutput - offset));
+    });
+  }
+
+ private:
+  PolyphaseResampler(int up, int down) : mUp(up), mDown(down) {
+    if (up == down) {
+      // Same rate, a single tap that copies
+      mCenter = 0;
+      mNumTaps = TAP_ALIGNMENT;
+      mPhases.resize(1, (size_t)mNumTaps);
+      mPhases[0][0] = 1.0f;
+      return;
+    }
+
+    // The filter runs at up times the input rate, cutting off under the lower of the two Nyquists
+    const double cutoff = juce::jmin(1.0, (double)up / down) * ROLLOFF;  // In input samples, 1 being the input Nyquist
+    const double halfWidth = ZERO_CROSSINGS / cutoff;                    // In input samples
+    const int numTaps = 2 * (int)std::ceil(halfWidth);
+    mCenter = numTaps / 2 - 1;
+    mNumTaps = (numTaps + TAP_ALIGNMENT - 1) / TAP_ALIGNMENT * TAP_ALIGNMENT;
+    mPhases.resize((size_t)up, (size_t)mNumTaps);
+
+    const double kaiserScale = 1.0 / besselI0(KAISER_BETA);
+    for (int phase = 0; phase < up; ++phase) {
+      float* taps = mPhases[(size_t)phase];
+      double sum = 0.0;
+      for (int k = 0; k < numTaps; ++k) {
+        // Distance in input samples from the output sample to the input sample of the tap
+        const double d = k - mCenter - (double)phase / up;
+        const double x = d / halfWidth;
+        if (std::abs(x) >= 1.0) continue;
+        const double sinc = (d == 0.0) ? 1.0 : std::sin(juce::MathConstants<double>::pi * cutoff * d) /
+                                                    (juce::MathConstants<double>::pi * cutoff * d);
+        const double value = cutoff * sinc * besselI0(KAISER_BETA * std::sqrt(1.0 - x * x)) * kaiserScale;
+        taps[k] = (float)value;
+        sum += value;
+      }
+      // Unity gain at DC for every phase, otherwise a ripple at the phase rate is added
+      if (sum != 0.0) {
+        for (int k = 0; k < numTaps; ++k) taps[k] = (float)(taps[k] / sum);
+      }
+    }
+  }
+
+  // Zeroth order modified Bessel function of the first kind, for the Kaiser window
+  static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64 && term > sum * 1e-12; ++k) {
+      term *= (x / (2.0 * k)) * (x / (2.0 * k));
+      sum += term;
+    }
+    return sum;
+  }
+
+  // Partial sums in independent lanes, which compilers keep in one SIMD register
+  float dot(const float* taps, const float* input) const {
+    float sums[TAP_ALIGNMENT] = {};
+    for (int k = 0; k < mNumTaps; k += TAP_ALIGNMENT) {
+      for (int lane = 0; lane < TAP_ALIGNMENT; ++lane) sums[lane] += taps[k + lane] * input[k + lane];
+    }
+    float sum = 0.0f;
+    for (float lane : sums) sum += lane;
+    return sum;
+  }
+
+  int mUp;
+  int mDown;
+  int mCenter = 0;   // Taps before the input sample an output sample is at or after
+  int mNumTaps = 0;  // Per phase, including the zero padding
+  Matrix<float> mPhases;  // Taps of each phase, one row per phase
+};
+
+}  // namespace Utils
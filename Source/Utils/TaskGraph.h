@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    TaskGraph.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Utils {
+
+/**
+ * One pool for the heavy background work of every plugin instance, so a few instances analyzing at once share the cores
+ * instead of each spinning up a thread per core. Hold a juce::SharedResourcePointer<SharedThreadPool> to use it.
+ */
+struct SharedThreadPool {
+  juce::ThreadPool pool{juce::jmax(2, juce::SystemStats::getNumCpus() - 1)};
+};
+
+/**
+ * Calls fn(i) for every i in [0, num), spread over the pool with the calling thread doing its share. Items are handed out
+ * as threads get to them, so it only ever waits on items that are already running and is safe to call from inside the pool.
+ */
+template <typename Fn>
+static void parallelFor(juce::ThreadPool& pool, int num, Fn&& fn) {
+  if (num <= 1) {
+    if (num == 1) fn(0);
+    return;
+  }
+  struct State {
+    std::atomic<int> next{0};
+    std::atomic<int> numDone{0};
+    juce::WaitableEvent finished;
+  };
+  // Helpers that only start after everything is done find nothing left, but still need the state
+  auto state = std::make_shared<State>();
+  const auto work = [state, num, &fn]() {
+    for (int i = state->next++; i < num; i = state->next++) {
+      fn(i);
+      if (++state->numDone == num) state->finished.signal();
+    }
+  };
+  const int numHelpers = juce::jmin(num - 1, pool.getNumThreads());
+  for (int h = 0; h < numHelpers; ++h) {
+    pool.addJob([work]() {
+      work();
+      return juce::ThreadPoolJob::jobHasFinished;
+    });
+  }
+  work();
+  state->finished.wait();
+}
+
+/**
+ * Stages with dependencies between them, each stage is queued on a thread pool as soon as all the stages it depends on
+ * finished so independent stages run side by side.
+ * Stages can't wait on each other from inside the pool, which is what the dependencies are for. Once cancelled, stages
+ * that haven't started are skipped, the ones running are waited for.
+ */
+class TaskGraph {
+ public:
+  using TaskId = int;
+
+  // weight is the share of the progress the stage accounts for, relative to the other stages
+  TaskId add(std::function<void()> fn, std::vector<TaskId> dependencies = {}, float weight = 1.0f) {
+    auto task = std::make_unique<Task>();
+    task->fn = std::move(fn);
+    task->weight = weight;
+    task->numDependencies = (int)dependencies.size();
+    const TaskId id = (TaskId)mTasks.size();
+    for (TaskId dependency : dependencies) {
+      jassert(dependency >= 0 && dependency < id);  // Only stages added before, so there can't be cycles
+      mTasks[(size_t)dependency]->dependents.push_back(id);
+    }
+    mTotalWeight += weight;
+    mTasks.push_back(std::move(task));
+    return id;
+  }
+
+  /**
+   * Blocks until every stage ran or the graph was cancelled, shouldExit() is polled while waiting to cancel it.
+   * progress(0-1) is called from the pool threads as stages finish. Returns false if it was cancelled
+   */
+  bool run(juce::ThreadPool& pool, const std::function<bool()>& shouldExit = nullptr,
+           const std::function<void(float)>& progress = nullptr) {
+    mProgress = progress;
+    for (size_t i = 0; i < mTasks.size(); ++i) {
+      mTasks[i]->remaining = mTasks[i]->numDependencies;
+      if (mTasks[i]->numDependencies == 0) schedule(pool, (TaskId)i);
+    }
+    while (mNumRunning.load() > 0) {
+      if (!mIsCancelled && shouldExit && shouldExit()) cancel();
+      mTaskFinished.wait(POLL_MS);
+    }
+    return !mIsCancelled && mNumFinished.load() == (int)mTasks.size();
+  }
+
+  // Any thread, also for long stages to check if they can stop early
+  void cancel() { mIsCancelled = true; }
+  bool isCancelled() const { return mIsCancelled.load(); }
+
+ private:
+  static constexpr int POLL_MS = 20;
+
+  struct Task {
+    std::function<void()> fn;
+    std::vector<TaskId> dependents;
+    int numDependencies = 0;
+    float weight = 1.0f;
+    std::atomic<int> remaining{0};
+  };
+
+  void schedule(juce::ThreadPool& pool, TaskId id) {
+    mNumRunning++;
+    pool.addJob([this, &pool, id]() {
+      Task& task = *mTasks[(size_t)id];
+      if (!mIsCancelled) {
+        task.fn();
+        mNumFinished++;
+        reportProgress(task.weight);
+        for (TaskId dependent : task.dependents) {
+          if (--mTasks[(size_t)dependent]->remaining == 0 && !mIsCancelled) schedule(pool, dependent);
+        }
+      }
+      // Last, run() can return (and the graph be gone) as soon as this hits 0
+      mTaskFinished.signal();
+      mNumRunning--;
+      return juce::ThreadPoolJob::jobHasFinished;
+    });
+  }
+
+  void reportProgress(float weight) {
+    const juce::SpinLock::ScopedLockType lock(mProgressLock);
+    mFinishedWeight += weight;
+    if (mProgress) mProgress(mTotalWeight > 0.0f ? mFinishedWeight / mTotalWeight : 1.0f);
+  }
+
+  std::vector<std::unique_ptr<Task>> mTasks;
+  float mTotalWeight = 0.0f;
+  float mFinishedWeight = 0.0f;
+  juce::SpinLock mProgressLock;
+  std::function<void(float)> mProgress;
+  std::atomic<int> mNumRunning{0};
+  std::atomic<int> mNumFinished{0};
+  std::atomic<bool> mIsCancelled{false};
+  juce::WaitableEvent mTaskFinished;
+};
+
+}  // namespace Utils
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    Transport.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+
+namespace Utils {
+
+/**
+ * Host transport state, the playhead is read once at the start of each block.
+ * update() reports what changed so tempo dependent state is only recalculated when needed, and the ppq position lets synced
+ * grains land on the host's beat grid instead of drifting from adding up float intervals.
+ */
+class Transport {
+ public:
+  static constexpr double DEFAULT_BPM = 120.0;
+  // Some hosts report 0 while stopped or without a tempo, the intervals in samples divide by it
+  static constexpr double MIN_BPM = 1.0;
+  static constexpr int DEFAULT_BEATS_PER_BAR = 4;
+  static constexpr int DEFAULT_BEAT_UNIT = 4;  // Time signature denominator
+  // How far (in quarter notes) the position can be from where the last block left it before it's considered a jump
+  static constexpr double PPQ_TOLERANCE = 1.0e-3;
+
+  enum Change {
+    NONE = 0,
+    TEMPO = 1 << 0,
+    TIME_SIGNATURE = 1 << 1,
+    POSITION = 1 << 2,  // started/stopped, looped or moved
+  };
+
+  // Next update() reports everything as changed
+  void prepare(double sampleRate) {
+    mSampleRate = sampleRate;
+    mBpm = 0.0;
+    mBeatsPerBar = 0;
+    mBeatUnit = 0;
+    mLastBlockSize = 0;
+  }
+
+  // Returns the Change flags since the last block
+  int update(juce::AudioPlayHead* playhead, int blockSize) {
+    double bpm = DEFAULT_BPM;
+    int beatsPerBar = DEFAULT_BEATS_PER_BAR;
+    int beatUnit = DEFAULT_BEAT_UNIT;
+    bool isPlaying = false;
+    bool hasPpq = false;
+    double ppq = 0.0;
+    if (playhead != nullptr) {
+      if (const auto position = playhead->getPosition()) {
+        if (const auto hostBpm = position->getBpm()) bpm = juce::jmax(MIN_BPM, *hostBpm);
+        if (const auto timeSig = position->getTimeSignature()) {
+          // Some hosts leave it zeroed while they don't know it
+          if (timeSig->numerator > 0 && timeSig->denominator > 0) {
+            beatsPerBar = timeSig->numerator;
+            beatUnit = timeSig->denominator;
+          }
+        }
+        if (const auto hostPpq = position->getPpqPosition()) {
+          ppq = *hostPpq;
+          hasPpq = true;
+        }
+        isPlaying = position->getIsPlaying();
+      }
+    }
+
+    int changes = NONE;
+    if (bpm != mBpm) changes |= TEMPO;
+    if (beatsPerBar != mBeatsPerBar || beatUnit != mBeatUnit) changes |= TIME_SIGNATURE;
+    if (isPlaying != mIsPlaying || hasPpq != mHasPpq ||
+        (hasPpq && std::abs(ppq - getPpq(mLastBlockSize)) > PPQ_TOLERANCE)) {
+      changes |= POSITION;
+    }
+
+    mBpm = bpm;
+    mBeatsPerBar = beatsPerBar;
+    mBeatUnit = beatUnit;
+    mIsPlaying = isPlaying;
+    mHasPpq = hasPpq;
+    mPpq = ppq;
+    mLastBlockSize = blockSize;
+    return changes;
+  }
+
+  double getBpm() const { return mBpm; }
+  int getBeatsPerBar() const { return mBeatsPerBar; }
+  int getBeatUnit() const { return mBeatUnit; }
+  // The bpm and ppq count quarter notes, so a 6/8 bar is 3 of them
+  double getPpqPerBar() const { return mBeatsPerBar * 4.0 / mBeatUnit; }
+  double getSecPerBar() const { return (60.0 / mBpm) * getPpqPerBar(); }
+  // Beat locked timing is only possible while the host is playing and tells us where it is
+  bool isPlaying() const { return mIsPlaying && mHasPpq; }
+
+  double getPpqPerSample() const { return mBpm / (60.0 * mSampleRate); }
+  // Position in quarter notes at a sample offset from the start of the current block
+  double getPpq(int sampleOffset) const { return mPpq + sampleOffset * getPpqPerSample(); }
+
+  // Samples from the start of the current block to the first multiple of intervalPpq at or after fromSample
+  int getSamplesToGrid(double intervalPpq, int fromSample) const {
+    jassert(intervalPpq > 0.0);
+    if (intervalPpq <= 0.0 || getPpqPerSample() <= 0.0) return fromSample;  // Before the first update()
+    const double ppq = getPpq(fromSample);
+    // Small epsilon so a position that is on the grid but off by float error isn't pushed a whole interval back
+    const double gridPpq = std::ceil(ppq / intervalPpq - 1.0e-6) * intervalPpq;
+    return fromSample + juce::jmax(0, (int)std::round((gridPpq - ppq) / getPpqPerSample()));
+  }
+
+ private:
+  double mSampleRate = 48000.0;
+  double mBpm = 0.0;
+  int mBeatsPerBar = 0;
+  int mBeatUnit = 0;
+  bool mIsPlaying = false;
+  bool mHasPpq = false;
+  double mPpq = 0.0;
+  int mLastBlockSize = 0;
+};
+
+}  // namespace Utils
@@ -5,6 +5,7 @@ import sys
 import struct
 import os
 import xml.dom.minidom
+import zlib
 
 def parseInfo(filePath):
   file = open(filePath, "rb")
@@ -63,6 +64,54 @@ def parseInfo(filePath):
 
       print(xmlDom.toprettyxml())
 
+  elif versionMajor == 1:
+      numChunks = int.from_bytes(file.read(4), "little")
+      skip = file.read(8 * 4) # uint32_t reserved[8];
+      chunkNames = {0: "audio", 1: "analysis", 2: "images", 3: "params"}
+      chunks = []
+      print("Chunks:")
+      for i in range(numChunks):
+        chunkType, _, offset, size = struct.unpack('<IIQQ', file.read(24))
+        chunks.append((chunkType, offset, size))
+        print("\t{}: offset {} size {}".format(chunkNames.get(chunkType, "unknown ({})".format(chunkType)), offset, size))
+
+      for chunkType, offset, size in chunks:
+        file.seek(offset)
+        if chunkType == 0:
+          sampleRate, numSamples, numChannels, encoding, scale = struct.unpack('<diiIf', file.read(24))
+          print("Audio Buffer info:")
+          print("\tsampler rate: {}".format(sampleRate))
+          print("\tnumber of samples: {}".format(numSamples))
+          print("\tchannel: {}".format(numChannels))
+          print("\tencoding: {}".format({0: "float32", 1: "float32 packed", 2: "int16"}.get(encoding, encoding)))
+          if encoding == 2:
+            print("\tscale: {}".format(scale))
+          print("\tstored size: {} (raw {})".format(size - 32, numSamples * numChannels * 4))
+        elif chunkType == 1:
+          numFrames, numEvents, numSpecs, noteSensitivity, splitSensitivity, minNoteLengthMs = struct.unpack('<IIIfff', file.read(24))
+          print("Analysis info:")
+          print("\tframes: {}".format(numFrames))
+          print("\tnote events: {}".format(numEvents))
+          print("\tspectrograms: {}".format(numSpecs))
+          print("\tnote detection: sensitivity {} split {} min length {} ms".format(noteSensitivity, splitSensitivity, minNoteLengthMs))
+          print("\tstored size: {}".format(size - 32))
+        elif chunkType == 2:
+          numImages = int.from_bytes(file.read(4), "little")
+          skip = file.read(3 * 4)
+          # The images are zlib compressed after the count
+          pixels = zlib.decompressobj(zlib.MAX_WBITS | 32).decompress(file.read(size - 16))
+          print("Spectrogram image info:")
+          pos = 0
+          for j in range(numImages):
+            specType, width, height, _ = struct.unpack_from('<IiiI', pixels, pos)
+            print("\tspec type {}: {}x{}".format(specType, width, height))
+            pos += 16 + width * height * 4
+        elif chunkType == 3:
+          # copyXmlToBinary() adds a magic and size before the XML
+          xmlData = file.read(size).decode("utf-8", errors="ignore")
+          xmlData = xmlData[xmlData.index("<?xml"):].rstrip("\x00")
+          print(xml.dom.minidom.parseString(xmlData).toprettyxml())
+
   else:
       print("File version not recognized")
 